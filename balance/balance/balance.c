@@ -23,7 +23,7 @@
 #include "conf/datatypes.h"
 #include "conf/confparser.h"
 #include "conf/confxml.h"
-#include "conf/buffer.h"
+#include "buffer.h"
 
 #include <math.h>
 #include <string.h>
@@ -32,14 +32,17 @@
 #include "balance_filter.h"
 
 #include "vesc_c_if.h"
+#include "fast_code.h"
 
 #include <math.h>
 
-static inline float inv_sqrt(float x) {
+// Everything that balance_filter_update calls has to be inlined, as it runs from
+// RAM
+static inline __attribute__((always_inline)) float inv_sqrt(float x) {
     return 1.0 / sqrtf(x);
 }
 
-static float calculate_acc_confidence(float new_acc_mag, BalanceFilterData *data) {
+static inline __attribute__((always_inline)) float calculate_acc_confidence(float new_acc_mag, BalanceFilterData *data) {
     // G.K. Egan (C) computes confidence in accelerometers when
     // aircraft is being accelerated over and above that due to gravity
     data->acc_mag = data->acc_mag * 0.9 + new_acc_mag * 0.1;
@@ -67,7 +70,7 @@ void balance_filter_configure(BalanceFilterData *data, const balance_config *con
     data->kp_yaw = config->mahony_kp_yaw;
 }
 
-void balance_filter_update(BalanceFilterData *data, float *gyro_xyz, float *accel_xyz, float dt) {
+FAST_CODE void balance_filter_update(BalanceFilterData *data, float *gyro_xyz, float *accel_xyz, float dt) {
     float gx = gyro_xyz[0];
     float gy = gyro_xyz[1];
     float gz = gyro_xyz[2];
@@ -23,9 +23,10 @@
 #include "conf/datatypes.h"
 #include "conf/confparser.h"
 #include "conf/confxml.h"
-#include "conf/buffer.h"
+#include "buffer.h"
 
 #include "balance_filter.h"
+#include "fast_code.h"
 
 #include <math.h>
 #include <string.h>
@@ -151,6 +152,12 @@ typedef struct {
     // IMU data for the balancing filter
     BalanceFilterData balance_filter;
 
+	// The IMU filter update is called from the copy in RAM if there was memory
+	// for it. Small functions such as biquad_process stay in flash, where they
+	// are inlined, which saves more than the wait states of a call would.
+	fast_code_t fast_code;
+	void (*filter_update)(BalanceFilterData*, float*, float*, float);
+
 	// Temp tiltback
 	float mc_fet_start_temp;
 	float mc_mot_start_temp;
@@ -1251,7 +1258,7 @@ static void get_tuneC_current(data *d)
 
 static void imu_ref_callback(float *acc, float *gyro, float *mag, float dt) {
 	data *d = (data*)ARG;
-    balance_filter_update(&d->balance_filter, gyro, acc, dt);
+    d->filter_update(&d->balance_filter, gyro, acc, dt);
 }
 
 static void balance_thd(void *arg) {
@@ -1808,7 +1815,9 @@ static void stop(void *arg) {
 	data *d = (data*)arg;
 	VESC_IF->set_app_data_handler(NULL);
 	VESC_IF->conf_custom_clear_configs();
+	VESC_IF->imu_set_read_callback(NULL);
 	VESC_IF->request_terminate(d->thread);
+	fast_code_free(&d->fast_code);
 	VESC_IF->printf("Balance App Terminated");
 	VESC_IF->free(d);
 }
@@ -1851,6 +1860,9 @@ INIT_FUN(lib_info *info) {
 
 	info->stop_fun = stop;	
 	info->arg = d;
+
+	fast_code_load(&d->fast_code);
+	d->filter_update = fast_code_fn(&d->fast_code, balance_filter_update);
 	
 	VESC_IF->conf_custom_add_config(get_cfg, set_cfg, get_cfg_xml);
 
@@ -1,385 +1,149 @@
-// This file is autogenerated by VESC Tool
+// This file is autogenerated by c_libs/conftable.py from settings.xml
 
-#include <string.h>
-#include "buffer.h"
 #include "conf_general.h"
 #include "confparser.h"
 
-int32_t confparser_serialize_balance_config(uint8_t *buffer, const balance_config *conf) {
-	int32_t ind = 0;
-
-	buffer_append_uint32(buffer, BALANCE_CONFIG_SIGNATURE, &ind);
+static const conftable_field fields[] = {
+	CONFTABLE_FLOAT(balance_config, pitch_th, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_PITCH_TH),
+	CONFTABLE_FLOAT(balance_config, pitch_th_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_PITCH_TH_B),
+	CONFTABLE_FLOAT(balance_config, pitch_th_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_PITCH_TH_C),
+	CONFTABLE_FLOAT(balance_config, pitch_thi, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_PITCH_THI),
+	CONFTABLE_FLOAT(balance_config, pitch_thi_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_PITCH_THI_B),
+	CONFTABLE_FLOAT(balance_config, pitch_thi_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_PITCH_THI_C),
+	CONFTABLE_FLOAT(balance_config, gyro_th, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_GYRO_TH),
+	CONFTABLE_FLOAT(balance_config, gyro_th_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_GYRO_TH_B),
+	CONFTABLE_FLOAT(balance_config, gyro_th_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_GYRO_TH_C),
+	CONFTABLE_FLOAT(balance_config, current_out_filter, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_CURRENT_OUT_FILTER),
+	CONFTABLE_FLOAT(balance_config, current_out_filter_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_CURRENT_OUT_FILTER_B),
+	CONFTABLE_FLOAT(balance_config, current_out_filter_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_CURRENT_OUT_FILTER_C),
+	CONFTABLE_INT(balance_config, tune_b_only_for_brakes, CONFTABLE_BOOL, APPCONF_BALANCE_TUNE_B_ONLY_FOR_BRAKES),
+	CONFTABLE_INT(balance_config, tune_c_only_for_brakes, CONFTABLE_BOOL, APPCONF_BALANCE_TUNE_C_ONLY_FOR_BRAKES),
+	CONFTABLE_FLOAT(balance_config, brake_max_amp_change, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BRAKE_MAX_AMPS),
+	CONFTABLE_FLOAT(balance_config, brake_max_amp_change_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BRAKE_MAX_AMPS_B),
+	CONFTABLE_FLOAT(balance_config, brake_max_amp_change_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BRAKE_MAX_AMPS_C),
+	CONFTABLE_FLOAT(balance_config, pitch_thi_limit, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_PITCH_THI_LIMIT),
+	CONFTABLE_FLOAT(balance_config, pitch_thi_limit_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_PITCH_THI_LIMIT_B),
+	CONFTABLE_FLOAT(balance_config, pitch_thi_limit_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_PITCH_THI_LIMIT_C),
+	CONFTABLE_INT(balance_config, reset_pitch_thi_on_entering_b, CONFTABLE_BOOL, APPCONF_BALANCE_RESET_PITCH_THI_ON_ENTERING_B),
+	CONFTABLE_INT(balance_config, reset_pitch_thi_on_entering_c, CONFTABLE_BOOL, APPCONF_BALANCE_RESET_PITCH_THI_ON_ENTERING_C),
+	CONFTABLE_FLOAT(balance_config, tunea_transition_speed, CONFTABLE_F32, 100, APPCONF_BALANCE_TUNEA_TRANSITION_SPEED),
+	CONFTABLE_FLOAT(balance_config, tuneb_transition_speed, CONFTABLE_F32, 100, APPCONF_BALANCE_TUNEB_TRANSITION_SPEED),
+	CONFTABLE_FLOAT(balance_config, tunec_transition_speed, CONFTABLE_F32, 100, APPCONF_BALANCE_TUNEC_TRANSITION_SPEED),
+	CONFTABLE_INT(balance_config, transitions_order, CONFTABLE_U8, APPCONF_BALANCE_TRANSITIONS_ORDER),
+	CONFTABLE_INT(balance_config, tunes_mixing_b, CONFTABLE_U8, APPCONF_BALANCE_TUNES_MIXING_B),
+	CONFTABLE_INT(balance_config, tunes_mixing_c, CONFTABLE_U8, APPCONF_BALANCE_TUNES_MIXING_C),
+	CONFTABLE_FLOAT(balance_config, asym_min_accel_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_ASYM_MIN_ACCEL_B),
+	CONFTABLE_FLOAT(balance_config, asym_max_accel_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_ASYM_MAX_ACCEL_B),
+	CONFTABLE_INT(balance_config, asym_min_erpm_b, CONFTABLE_U16, APPCONF_BALANCE_ASYM_MIN_ERPM_B),
+	CONFTABLE_INT(balance_config, asym_max_erpm_b, CONFTABLE_U16, APPCONF_BALANCE_ASYM_MAX_ERPM_B),
+	CONFTABLE_FLOAT(balance_config, asym_min_accel_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_ASYM_MIN_ACCEL_C),
+	CONFTABLE_FLOAT(balance_config, asym_max_accel_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_ASYM_MAX_ACCEL_C),
+	CONFTABLE_INT(balance_config, asym_min_erpm_c, CONFTABLE_U16, APPCONF_BALANCE_ASYM_MIN_ERPM_C),
+	CONFTABLE_INT(balance_config, asym_max_erpm_c, CONFTABLE_U16, APPCONF_BALANCE_ASYM_MAX_ERPM_C),
+	CONFTABLE_FLOAT(balance_config, mahony_kp, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_MAHONY_KP),
+	CONFTABLE_FLOAT(balance_config, mahony_kp_roll, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_MAHONY_KP_ROLL),
+	CONFTABLE_FLOAT(balance_config, mahony_kp_yaw, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_MAHONY_KP_YAW),
+	CONFTABLE_FLOAT(balance_config, bf_accel_confidence_decay, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BF_ACCEL_CONF_DECAY),
+	CONFTABLE_INT(balance_config, hertz, CONFTABLE_U16, APPCONF_BALANCE_HERTZ),
+	CONFTABLE_INT(balance_config, loop_time_filter, CONFTABLE_U16, APPCONF_BALANCE_LOOP_TIME_FILTER),
+	CONFTABLE_FLOAT(balance_config, fault_pitch, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_FAULT_PITCH),
+	CONFTABLE_FLOAT(balance_config, fault_roll, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_FAULT_ROLL),
+	CONFTABLE_FLOAT(balance_config, fault_adc1, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_FAULT_ADC1),
+	CONFTABLE_FLOAT(balance_config, fault_adc2, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_FAULT_ADC2),
+	CONFTABLE_INT(balance_config, fault_delay_pitch, CONFTABLE_U16, APPCONF_BALANCE_FAULT_DELAY_PITCH),
+	CONFTABLE_INT(balance_config, fault_delay_roll, CONFTABLE_U16, APPCONF_BALANCE_FAULT_DELAY_ROLL),
+	CONFTABLE_INT(balance_config, fault_delay_switch_half, CONFTABLE_U16, APPCONF_BALANCE_FAULT_DELAY_SWITCH_HALF),
+	CONFTABLE_INT(balance_config, fault_delay_switch_full, CONFTABLE_U16, APPCONF_BALANCE_FAULT_DELAY_SWITCH_FULL),
+	CONFTABLE_INT(balance_config, fault_adc_half_erpm, CONFTABLE_U16, APPCONF_BALANCE_FAULT_ADC_HALF_ERPM),
+	CONFTABLE_INT(balance_config, fault_is_single_switch, CONFTABLE_BOOL, APPCONF_BALANCE_FAULT_IS_SINGLE_SWITCH),
+	CONFTABLE_FLOAT(balance_config, tiltback_duty_angle, CONFTABLE_F16, 100, APPCONF_BALANCE_TILTBACK_DUTY_ANGLE),
+	CONFTABLE_FLOAT(balance_config, tiltback_duty_speed, CONFTABLE_F16, 100, APPCONF_BALANCE_TILTBACK_DUTY_SPEED),
+	CONFTABLE_FLOAT(balance_config, tiltback_duty, CONFTABLE_F16, 1000, APPCONF_BALANCE_TILTBACK_DUTY),
+	CONFTABLE_FLOAT(balance_config, tiltback_hv_angle, CONFTABLE_F16, 100, APPCONF_BALANCE_TILTBACK_HV_ANGLE),
+	CONFTABLE_FLOAT(balance_config, tiltback_hv_speed, CONFTABLE_F16, 100, APPCONF_BALANCE_TILTBACK_HV_SPEED),
+	CONFTABLE_FLOAT(balance_config, tiltback_hv, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TILTBACK_HV),
+	CONFTABLE_FLOAT(balance_config, tiltback_lv_angle, CONFTABLE_F16, 100, APPCONF_BALANCE_TILTBACK_LV_ANGLE),
+	CONFTABLE_FLOAT(balance_config, tiltback_lv_speed, CONFTABLE_F16, 100, APPCONF_BALANCE_TILTBACK_LV_SPEED),
+	CONFTABLE_FLOAT(balance_config, tiltback_lv, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TILTBACK_LV),
+	CONFTABLE_FLOAT(balance_config, tiltback_return_speed, CONFTABLE_F16, 100, APPCONF_BALANCE_TILTBACK_RETURN_SPEED),
+	CONFTABLE_FLOAT(balance_config, tiltback_constant, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TILTBACK_CONSTANT),
+	CONFTABLE_INT(balance_config, tiltback_constant_erpm, CONFTABLE_U16, APPCONF_BALANCE_TILTBACK_CONSTANT_ERPM),
+	CONFTABLE_FLOAT(balance_config, tiltback_variable, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TILTBACK_VARIABLE),
+	CONFTABLE_FLOAT(balance_config, tiltback_variable_max, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TILTBACK_VARIABLE_MAX),
+	CONFTABLE_INT(balance_config, tiltback_variable_start_erpm, CONFTABLE_U16, APPCONF_BALANCE_TILTBACK_VARIABLE_START_ERPM),
+	CONFTABLE_FLOAT(balance_config, noseangling_speed, CONFTABLE_F16, 100, APPCONF_BALANCE_NOSEANGLING_SPEED),
+	CONFTABLE_FLOAT(balance_config, startup_pitch_tolerance, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_STARTUP_PITCH_TOLERANCE),
+	CONFTABLE_FLOAT(balance_config, startup_roll_tolerance, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_STARTUP_ROLL_TOLERANCE),
+	CONFTABLE_FLOAT(balance_config, startup_speed, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_STARTUP_SPEED),
+	CONFTABLE_FLOAT(balance_config, brake_current, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BRAKE_CURRENT),
+	CONFTABLE_FLOAT(balance_config, torquetilt_start_current, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TORQUETILT_START_CURRENT),
+	CONFTABLE_FLOAT(balance_config, torquetilt_start_current_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TORQUETILT_START_CURRENT_B),
+	CONFTABLE_FLOAT(balance_config, torquetilt_angle_limit, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TORQUETILT_ANGLE_LIMIT),
+	CONFTABLE_FLOAT(balance_config, torquetilt_on_speed, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TORQUETILT_ON_SPEED),
+	CONFTABLE_FLOAT(balance_config, torquetilt_off_speed, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TORQUETILT_OFF_SPEED),
+	CONFTABLE_FLOAT(balance_config, torquetilt_strength, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TORQUETILT_STRENGTH),
+	CONFTABLE_FLOAT(balance_config, torquetilt_strength_regen, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TORQUETILT_STRENGTH_REGEN),
+	CONFTABLE_FLOAT(balance_config, torquetilt_filter, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TORQUETILT_FILTER),
+	CONFTABLE_INT(balance_config, turntilt_mixing_mode, CONFTABLE_U8, APPCONF_BALANCE_TURNTILT_MIXING_MODE),
+	CONFTABLE_FLOAT(balance_config, roll_turntilt_weight, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_ROLL_TURNTILT_WEIGHT),
+	CONFTABLE_FLOAT(balance_config, roll_turntilt_strength, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_ROLL_TURNTILT_STRENGTH),
+	CONFTABLE_FLOAT(balance_config, roll_turntilt_angle_limit, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_ROLL_TURNTILT_ANGLE_LIMIT),
+	CONFTABLE_FLOAT(balance_config, roll_turntilt_start_angle, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_ROLL_TURNTILT_START_ANGLE),
+	CONFTABLE_INT(balance_config, roll_turntilt_start_erpm, CONFTABLE_U16, APPCONF_BALANCE_ROLL_TURNTILT_START_ERPM),
+	CONFTABLE_FLOAT(balance_config, roll_turntilt_speed, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_ROLL_TURNTILT_SPEED),
+	CONFTABLE_INT(balance_config, roll_turntilt_erpm_boost, CONFTABLE_U16, APPCONF_BALANCE_ROLL_TURNTILT_ERPM_BOOST),
+	CONFTABLE_INT(balance_config, roll_turntilt_erpm_boost_end, CONFTABLE_U16, APPCONF_BALANCE_ROLL_TURNTILT_ERPM_BOOST_END),
+	CONFTABLE_FLOAT(balance_config, yaw_turntilt_weight, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_YAW_TURNTILT_WEIGHT),
+	CONFTABLE_FLOAT(balance_config, yaw_turntilt_strength, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_YAW_TURNTILT_STRENGTH),
+	CONFTABLE_FLOAT(balance_config, yaw_turntilt_angle_limit, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_YAW_TURNTILT_ANGLE_LIMIT),
+	CONFTABLE_FLOAT(balance_config, yaw_turntilt_start_angle, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_YAW_TURNTILT_START_ANGLE),
+	CONFTABLE_INT(balance_config, yaw_turntilt_start_erpm, CONFTABLE_U16, APPCONF_BALANCE_YAW_TURNTILT_START_ERPM),
+	CONFTABLE_FLOAT(balance_config, yaw_turntilt_speed, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_YAW_TURNTILT_SPEED),
+	CONFTABLE_INT(balance_config, yaw_turntilt_erpm_boost, CONFTABLE_U16, APPCONF_BALANCE_YAW_TURNTILT_ERPM_BOOST),
+	CONFTABLE_INT(balance_config, yaw_turntilt_erpm_boost_end, CONFTABLE_U16, APPCONF_BALANCE_YAW_TURNTILT_ERPM_BOOST_END),
+	CONFTABLE_INT(balance_config, yaw_turntilt_aggregate, CONFTABLE_U16, APPCONF_BALANCE_YAW_TURNTILT_AGGREGATE),
+	CONFTABLE_FLOAT(balance_config, temp_tiltback_start_offset, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TEMP_TILTBACK_START),
+	CONFTABLE_FLOAT(balance_config, temp_tiltback_speed, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TEMP_TILTBACK_SPEED),
+	CONFTABLE_FLOAT(balance_config, temp_tiltback_angle, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TEMP_TILTBACK_ANGLE),
+	CONFTABLE_INT(balance_config, enable_reverse_stop, CONFTABLE_BOOL, APPCONF_BALANCE_REVERSE_STOP),
+	CONFTABLE_INT(balance_config, enable_quickstop, CONFTABLE_BOOL, APPCONF_BALANCE_ENABLE_QUICKSTOP),
+	CONFTABLE_INT(balance_config, quickstop_erpm, CONFTABLE_U16, APPCONF_BALANCE_QUICKSTOP_ERPM),
+	CONFTABLE_FLOAT(balance_config, quickstop_angle, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_QUICKSTOP_ANGLE),
+	CONFTABLE_INT(balance_config, startup_click_current, CONFTABLE_U16, APPCONF_BALANCE_STARTUP_CLICK_CURRENT),
+	CONFTABLE_INT(balance_config, enable_traction_control, CONFTABLE_BOOL, APPCONF_BALANCE_ENABLE_TRACTION_CONTROL),
+	CONFTABLE_FLOAT(balance_config, traction_control_mul_by, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_TRACTION_CONTROL_MUL_BY),
+	CONFTABLE_FLOAT(balance_config, booster_min_pitch, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BOOSTER_MIN_PITCH),
+	CONFTABLE_FLOAT(balance_config, booster_max_pitch, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BOOSTER_MAX_PITCH),
+	CONFTABLE_FLOAT(balance_config, booster_current_limit, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BOOSTER_CURRENT_LIMIT),
+	CONFTABLE_FLOAT(balance_config, booster_min_pitch_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BOOSTER_MIN_PITCH_B),
+	CONFTABLE_FLOAT(balance_config, booster_max_pitch_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BOOSTER_MAX_PITCH_B),
+	CONFTABLE_FLOAT(balance_config, booster_current_limit_b, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BOOSTER_CURRENT_LIMIT_B),
+	CONFTABLE_FLOAT(balance_config, booster_min_pitch_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BOOSTER_MIN_PITCH_C),
+	CONFTABLE_FLOAT(balance_config, booster_max_pitch_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BOOSTER_MAX_PITCH_C),
+	CONFTABLE_FLOAT(balance_config, booster_current_limit_c, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_BOOSTER_CURRENT_LIMIT_C),
+	CONFTABLE_FLOAT(balance_config, softstart_speed, CONFTABLE_F32_AUTO, 0.0, APPCONF_BALANCE_SOFTSTART_SPEED),
+};
 
-	buffer_append_float32_auto(buffer, conf->pitch_th, &ind);
-	buffer_append_float32_auto(buffer, conf->pitch_th_b, &ind);
-	buffer_append_float32_auto(buffer, conf->pitch_th_c, &ind);
-	buffer_append_float32_auto(buffer, conf->pitch_thi, &ind);
-	buffer_append_float32_auto(buffer, conf->pitch_thi_b, &ind);
-	buffer_append_float32_auto(buffer, conf->pitch_thi_c, &ind);
-	buffer_append_float32_auto(buffer, conf->gyro_th, &ind);
-	buffer_append_float32_auto(buffer, conf->gyro_th_b, &ind);
-	buffer_append_float32_auto(buffer, conf->gyro_th_c, &ind);
-	buffer_append_float32_auto(buffer, conf->current_out_filter, &ind);
-	buffer_append_float32_auto(buffer, conf->current_out_filter_b, &ind);
-	buffer_append_float32_auto(buffer, conf->current_out_filter_c, &ind);
-	buffer[ind++] = conf->tune_b_only_for_brakes;
-	buffer[ind++] = conf->tune_c_only_for_brakes;
-	buffer_append_float32_auto(buffer, conf->brake_max_amp_change, &ind);
-	buffer_append_float32_auto(buffer, conf->brake_max_amp_change_b, &ind);
-	buffer_append_float32_auto(buffer, conf->brake_max_amp_change_c, &ind);
-	buffer_append_float32_auto(buffer, conf->pitch_thi_limit, &ind);
-	buffer_append_float32_auto(buffer, conf->pitch_thi_limit_b, &ind);
-	buffer_append_float32_auto(buffer, conf->pitch_thi_limit_c, &ind);
-	buffer[ind++] = conf->reset_pitch_thi_on_entering_b;
-	buffer[ind++] = conf->reset_pitch_thi_on_entering_c;
-	buffer_append_float32(buffer, conf->tunea_transition_speed, 100, &ind);
-	buffer_append_float32(buffer, conf->tuneb_transition_speed, 100, &ind);
-	buffer_append_float32(buffer, conf->tunec_transition_speed, 100, &ind);
-	buffer[ind++] = conf->transitions_order;
-	buffer[ind++] = conf->tunes_mixing_b;
-	buffer[ind++] = conf->tunes_mixing_c;
-	buffer_append_float32_auto(buffer, conf->asym_min_accel_b, &ind);
-	buffer_append_float32_auto(buffer, conf->asym_max_accel_b, &ind);
-	buffer_append_uint16(buffer, conf->asym_min_erpm_b, &ind);
-	buffer_append_uint16(buffer, conf->asym_max_erpm_b, &ind);
-	buffer_append_float32_auto(buffer, conf->asym_min_accel_c, &ind);
-	buffer_append_float32_auto(buffer, conf->asym_max_accel_c, &ind);
-	buffer_append_uint16(buffer, conf->asym_min_erpm_c, &ind);
-	buffer_append_uint16(buffer, conf->asym_max_erpm_c, &ind);
-	buffer_append_float32_auto(buffer, conf->mahony_kp, &ind);
-	buffer_append_float32_auto(buffer, conf->mahony_kp_roll, &ind);
-	buffer_append_float32_auto(buffer, conf->mahony_kp_yaw, &ind);
-	buffer_append_float32_auto(buffer, conf->bf_accel_confidence_decay, &ind);
-	buffer_append_uint16(buffer, conf->hertz, &ind);
-	buffer_append_uint16(buffer, conf->loop_time_filter, &ind);
-	buffer_append_float32_auto(buffer, conf->fault_pitch, &ind);
-	buffer_append_float32_auto(buffer, conf->fault_roll, &ind);
-	buffer_append_float32_auto(buffer, conf->fault_adc1, &ind);
-	buffer_append_float32_auto(buffer, conf->fault_adc2, &ind);
-	buffer_append_uint16(buffer, conf->fault_delay_pitch, &ind);
-	buffer_append_uint16(buffer, conf->fault_delay_roll, &ind);
-	buffer_append_uint16(buffer, conf->fault_delay_switch_half, &ind);
-	buffer_append_uint16(buffer, conf->fault_delay_switch_full, &ind);
-	buffer_append_uint16(buffer, conf->fault_adc_half_erpm, &ind);
-	buffer[ind++] = conf->fault_is_single_switch;
-	buffer_append_float16(buffer, conf->tiltback_duty_angle, 100, &ind);
-	buffer_append_float16(buffer, conf->tiltback_duty_speed, 100, &ind);
-	buffer_append_float16(buffer, conf->tiltback_duty, 1000, &ind);
-	buffer_append_float16(buffer, conf->tiltback_hv_angle, 100, &ind);
-	buffer_append_float16(buffer, conf->tiltback_hv_speed, 100, &ind);
-	buffer_append_float32_auto(buffer, conf->tiltback_hv, &ind);
-	buffer_append_float16(buffer, conf->tiltback_lv_angle, 100, &ind);
-	buffer_append_float16(buffer, conf->tiltback_lv_speed, 100, &ind);
-	buffer_append_float32_auto(buffer, conf->tiltback_lv, &ind);
-	buffer_append_float16(buffer, conf->tiltback_return_speed, 100, &ind);
-	buffer_append_float32_auto(buffer, conf->tiltback_constant, &ind);
-	buffer_append_uint16(buffer, conf->tiltback_constant_erpm, &ind);
-	buffer_append_float32_auto(buffer, conf->tiltback_variable, &ind);
-	buffer_append_float32_auto(buffer, conf->tiltback_variable_max, &ind);
-	buffer_append_uint16(buffer, conf->tiltback_variable_start_erpm, &ind);
-	buffer_append_float16(buffer, conf->noseangling_speed, 100, &ind);
-	buffer_append_float32_auto(buffer, conf->startup_pitch_tolerance, &ind);
-	buffer_append_float32_auto(buffer, conf->startup_roll_tolerance, &ind);
-	buffer_append_float32_auto(buffer, conf->startup_speed, &ind);
-	buffer_append_float32_auto(buffer, conf->brake_current, &ind);
-	buffer_append_float32_auto(buffer, conf->torquetilt_start_current, &ind);
-	buffer_append_float32_auto(buffer, conf->torquetilt_start_current_b, &ind);
-	buffer_append_float32_auto(buffer, conf->torquetilt_angle_limit, &ind);
-	buffer_append_float32_auto(buffer, conf->torquetilt_on_speed, &ind);
-	buffer_append_float32_auto(buffer, conf->torquetilt_off_speed, &ind);
-	buffer_append_float32_auto(buffer, conf->torquetilt_strength, &ind);
-	buffer_append_float32_auto(buffer, conf->torquetilt_strength_regen, &ind);
-	buffer_append_float32_auto(buffer, conf->torquetilt_filter, &ind);
-	buffer[ind++] = conf->turntilt_mixing_mode;
-	buffer_append_float32_auto(buffer, conf->roll_turntilt_weight, &ind);
-	buffer_append_float32_auto(buffer, conf->roll_turntilt_strength, &ind);
-	buffer_append_float32_auto(buffer, conf->roll_turntilt_angle_limit, &ind);
-	buffer_append_float32_auto(buffer, conf->roll_turntilt_start_angle, &ind);
-	buffer_append_uint16(buffer, conf->roll_turntilt_start_erpm, &ind);
-	buffer_append_float32_auto(buffer, conf->roll_turntilt_speed, &ind);
-	buffer_append_uint16(buffer, conf->roll_turntilt_erpm_boost, &ind);
-	buffer_append_uint16(buffer, conf->roll_turntilt_erpm_boost_end, &ind);
-	buffer_append_float32_auto(buffer, conf->yaw_turntilt_weight, &ind);
-	buffer_append_float32_auto(buffer, conf->yaw_turntilt_strength, &ind);
-	buffer_append_float32_auto(buffer, conf->yaw_turntilt_angle_limit, &ind);
-	buffer_append_float32_auto(buffer, conf->yaw_turntilt_start_angle, &ind);
-	buffer_append_uint16(buffer, conf->yaw_turntilt_start_erpm, &ind);
-	buffer_append_float32_auto(buffer, conf->yaw_turntilt_speed, &ind);
-	buffer_append_uint16(buffer, conf->yaw_turntilt_erpm_boost, &ind);
-	buffer_append_uint16(buffer, conf->yaw_turntilt_erpm_boost_end, &ind);
-	buffer_append_uint16(buffer, conf->yaw_turntilt_aggregate, &ind);
-	buffer_append_float32_auto(buffer, conf->temp_tiltback_start_offset, &ind);
-	buffer_append_float32_auto(buffer, conf->temp_tiltback_speed, &ind);
-	buffer_append_float32_auto(buffer, conf->temp_tiltback_angle, &ind);
-	buffer[ind++] = conf->enable_reverse_stop;
-	buffer[ind++] = conf->enable_quickstop;
-	buffer_append_uint16(buffer, conf->quickstop_erpm, &ind);
-	buffer_append_float32_auto(buffer, conf->quickstop_angle, &ind);
-	buffer_append_uint16(buffer, conf->startup_click_current, &ind);
-	buffer[ind++] = conf->enable_traction_control;
-	buffer_append_float32_auto(buffer, conf->traction_control_mul_by, &ind);
-	buffer_append_float32_auto(buffer, conf->booster_min_pitch, &ind);
-	buffer_append_float32_auto(buffer, conf->booster_max_pitch, &ind);
-	buffer_append_float32_auto(buffer, conf->booster_current_limit, &ind);
-	buffer_append_float32_auto(buffer, conf->booster_min_pitch_b, &ind);
-	buffer_append_float32_auto(buffer, conf->booster_max_pitch_b, &ind);
-	buffer_append_float32_auto(buffer, conf->booster_current_limit_b, &ind);
-	buffer_append_float32_auto(buffer, conf->booster_min_pitch_c, &ind);
-	buffer_append_float32_auto(buffer, conf->booster_max_pitch_c, &ind);
-	buffer_append_float32_auto(buffer, conf->booster_current_limit_c, &ind);
-	buffer_append_float32_auto(buffer, conf->softstart_speed, &ind);
+void confparser_table_balance_config(conftable *t) {
+	t->signature = BALANCE_CONFIG_SIGNATURE;
+	t->fields = fields;
+	t->field_num = BALANCE_CONFIG_FIELD_NUM;
+}
 
-	return ind;
+int32_t confparser_serialize_balance_config(uint8_t *buffer, const balance_config *conf) {
+	conftable t;
+	confparser_table_balance_config(&t);
+	return conftable_serialize(&t, buffer, conf);
 }
 
 bool confparser_deserialize_balance_config(const uint8_t *buffer, balance_config *conf) {
-	int32_t ind = 0;
-
-	uint32_t signature = buffer_get_uint32(buffer, &ind);
-	if (signature != BALANCE_CONFIG_SIGNATURE) {
-		return false;
-	}
-
-	conf->pitch_th = buffer_get_float32_auto(buffer, &ind);
-	conf->pitch_th_b = buffer_get_float32_auto(buffer, &ind);
-	conf->pitch_th_c = buffer_get_float32_auto(buffer, &ind);
-	conf->pitch_thi = buffer_get_float32_auto(buffer, &ind);
-	conf->pitch_thi_b = buffer_get_float32_auto(buffer, &ind);
-	conf->pitch_thi_c = buffer_get_float32_auto(buffer, &ind);
-	conf->gyro_th = buffer_get_float32_auto(buffer, &ind);
-	conf->gyro_th_b = buffer_get_float32_auto(buffer, &ind);
-	conf->gyro_th_c = buffer_get_float32_auto(buffer, &ind);
-	conf->current_out_filter = buffer_get_float32_auto(buffer, &ind);
-	conf->current_out_filter_b = buffer_get_float32_auto(buffer, &ind);
-	conf->current_out_filter_c = buffer_get_float32_auto(buffer, &ind);
-	conf->tune_b_only_for_brakes = buffer[ind++];
-	conf->tune_c_only_for_brakes = buffer[ind++];
-	conf->brake_max_amp_change = buffer_get_float32_auto(buffer, &ind);
-	conf->brake_max_amp_change_b = buffer_get_float32_auto(buffer, &ind);
-	conf->brake_max_amp_change_c = buffer_get_float32_auto(buffer, &ind);
-	conf->pitch_thi_limit = buffer_get_float32_auto(buffer, &ind);
-	conf->pitch_thi_limit_b = buffer_get_float32_auto(buffer, &ind);
-	conf->pitch_thi_limit_c = buffer_get_float32_auto(buffer, &ind);
-	conf->reset_pitch_thi_on_entering_b = buffer[ind++];
-	conf->reset_pitch_thi_on_entering_c = buffer[ind++];
-	conf->tunea_transition_speed = buffer_get_float32(buffer, 100, &ind);
-	conf->tuneb_transition_speed = buffer_get_float32(buffer, 100, &ind);
-	conf->tunec_transition_speed = buffer_get_float32(buffer, 100, &ind);
-	conf->transitions_order = buffer[ind++];
-	conf->tunes_mixing_b = buffer[ind++];
-	conf->tunes_mixing_c = buffer[ind++];
-	conf->asym_min_accel_b = buffer_get_float32_auto(buffer, &ind);
-	conf->asym_max_accel_b = buffer_get_float32_auto(buffer, &ind);
-	conf->asym_min_erpm_b = buffer_get_uint16(buffer, &ind);
-	conf->asym_max_erpm_b = buffer_get_uint16(buffer, &ind);
-	conf->asym_min_accel_c = buffer_get_float32_auto(buffer, &ind);
-	conf->asym_max_accel_c = buffer_get_float32_auto(buffer, &ind);
-	conf->asym_min_erpm_c = buffer_get_uint16(buffer, &ind);
-	conf->asym_max_erpm_c = buffer_get_uint16(buffer, &ind);
-	conf->mahony_kp = buffer_get_float32_auto(buffer, &ind);
-	conf->mahony_kp_roll = buffer_get_float32_auto(buffer, &ind);
-	conf->mahony_kp_yaw = buffer_get_float32_auto(buffer, &ind);
-	conf->bf_accel_confidence_decay = buffer_get_float32_auto(buffer, &ind);
-	conf->hertz = buffer_get_uint16(buffer, &ind);
-	conf->loop_time_filter = buffer_get_uint16(buffer, &ind);
-	conf->fault_pitch = buffer_get_float32_auto(buffer, &ind);
-	conf->fault_roll = buffer_get_float32_auto(buffer, &ind);
-	conf->fault_adc1 = buffer_get_float32_auto(buffer, &ind);
-	conf->fault_adc2 = buffer_get_float32_auto(buffer, &ind);
-	conf->fault_delay_pitch = buffer_get_uint16(buffer, &ind);
-	conf->fault_delay_roll = buffer_get_uint16(buffer, &ind);
-	conf->fault_delay_switch_half = buffer_get_uint16(buffer, &ind);
-	conf->fault_delay_switch_full = buffer_get_uint16(buffer, &ind);
-	conf->fault_adc_half_erpm = buffer_get_uint16(buffer, &ind);
-	conf->fault_is_single_switch = buffer[ind++];
-	conf->tiltback_duty_angle = buffer_get_float16(buffer, 100, &ind);
-	conf->tiltback_duty_speed = buffer_get_float16(buffer, 100, &ind);
-	conf->tiltback_duty = buffer_get_float16(buffer, 1000, &ind);
-	conf->tiltback_hv_angle = buffer_get_float16(buffer, 100, &ind);
-	conf->tiltback_hv_speed = buffer_get_float16(buffer, 100, &ind);
-	conf->tiltback_hv = buffer_get_float32_auto(buffer, &ind);
-	conf->tiltback_lv_angle = buffer_get_float16(buffer, 100, &ind);
-	conf->tiltback_lv_speed = buffer_get_float16(buffer, 100, &ind);
-	conf->tiltback_lv = buffer_get_float32_auto(buffer, &ind);
-	conf->tiltback_return_speed = buffer_get_float16(buffer, 100, &ind);
-	conf->tiltback_constant = buffer_get_float32_auto(buffer, &ind);
-	conf->tiltback_constant_erpm = buffer_get_uint16(buffer, &ind);
-	conf->tiltback_variable = buffer_get_float32_auto(buffer, &ind);
-	conf->tiltback_variable_max = buffer_get_float32_auto(buffer, &ind);
-	conf->tiltback_variable_start_erpm = buffer_get_uint16(buffer, &ind);
-	conf->noseangling_speed = buffer_get_float16(buffer, 100, &ind);
-	conf->startup_pitch_tolerance = buffer_get_float32_auto(buffer, &ind);
-	conf->startup_roll_tolerance = buffer_get_float32_auto(buffer, &ind);
-	conf->startup_speed = buffer_get_float32_auto(buffer, &ind);
-	conf->brake_current = buffer_get_float32_auto(buffer, &ind);
-	conf->torquetilt_start_current = buffer_get_float32_auto(buffer, &ind);
-	conf->torquetilt_start_current_b = buffer_get_float32_auto(buffer, &ind);
-	conf->torquetilt_angle_limit = buffer_get_float32_auto(buffer, &ind);
-	conf->torquetilt_on_speed = buffer_get_float32_auto(buffer, &ind);
-	conf->torquetilt_off_speed = buffer_get_float32_auto(buffer, &ind);
-	conf->torquetilt_strength = buffer_get_float32_auto(buffer, &ind);
-	conf->torquetilt_strength_regen = buffer_get_float32_auto(buffer, &ind);
-	conf->torquetilt_filter = buffer_get_float32_auto(buffer, &ind);
-	conf->turntilt_mixing_mode = buffer[ind++];
-	conf->roll_turntilt_weight = buffer_get_float32_auto(buffer, &ind);
-	conf->roll_turntilt_strength = buffer_get_float32_auto(buffer, &ind);
-	conf->roll_turntilt_angle_limit = buffer_get_float32_auto(buffer, &ind);
-	conf->roll_turntilt_start_angle = buffer_get_float32_auto(buffer, &ind);
-	conf->roll_turntilt_start_erpm = buffer_get_uint16(buffer, &ind);
-	conf->roll_turntilt_speed = buffer_get_float32_auto(buffer, &ind);
-	conf->roll_turntilt_erpm_boost = buffer_get_uint16(buffer, &ind);
-	conf->roll_turntilt_erpm_boost_end = buffer_get_uint16(buffer, &ind);
-	conf->yaw_turntilt_weight = buffer_get_float32_auto(buffer, &ind);
-	conf->yaw_turntilt_strength = buffer_get_float32_auto(buffer, &ind);
-	conf->yaw_turntilt_angle_limit = buffer_get_float32_auto(buffer, &ind);
-	conf->yaw_turntilt_start_angle = buffer_get_float32_auto(buffer, &ind);
-	conf->yaw_turntilt_start_erpm = buffer_get_uint16(buffer, &ind);
-	conf->yaw_turntilt_speed = buffer_get_float32_auto(buffer, &ind);
-	conf->yaw_turntilt_erpm_boost = buffer_get_uint16(buffer, &ind);
-	conf->yaw_turntilt_erpm_boost_end = buffer_get_uint16(buffer, &ind);
-	conf->yaw_turntilt_aggregate = buffer_get_uint16(buffer, &ind);
-	conf->temp_tiltback_start_offset = buffer_get_float32_auto(buffer, &ind);
-	conf->temp_tiltback_speed = buffer_get_float32_auto(buffer, &ind);
-	conf->temp_tiltback_angle = buffer_get_float32_auto(buffer, &ind);
-	conf->enable_reverse_stop = buffer[ind++];
-	conf->enable_quickstop = buffer[ind++];
-	conf->quickstop_erpm = buffer_get_uint16(buffer, &ind);
-	conf->quickstop_angle = buffer_get_float32_auto(buffer, &ind);
-	conf->startup_click_current = buffer_get_uint16(buffer, &ind);
-	conf->enable_traction_control = buffer[ind++];
-	conf->traction_control_mul_by = buffer_get_float32_auto(buffer, &ind);
-	conf->booster_min_pitch = buffer_get_float32_auto(buffer, &ind);
-	conf->booster_max_pitch = buffer_get_float32_auto(buffer, &ind);
-	conf->booster_current_limit = buffer_get_float32_auto(buffer, &ind);
-	conf->booster_min_pitch_b = buffer_get_float32_auto(buffer, &ind);
-	conf->booster_max_pitch_b = buffer_get_float32_auto(buffer, &ind);
-	conf->booster_current_limit_b = buffer_get_float32_auto(buffer, &ind);
-	conf->booster_min_pitch_c = buffer_get_float32_auto(buffer, &ind);
-	conf->booster_max_pitch_c = buffer_get_float32_auto(buffer, &ind);
-	conf->booster_current_limit_c = buffer_get_float32_auto(buffer, &ind);
-	conf->softstart_speed = buffer_get_float32_auto(buffer, &ind);
-
-	return true;
+	conftable t;
+	confparser_table_balance_config(&t);
+	return conftable_deserialize(&t, buffer, conf, NULL);
 }
 
 void confparser_set_defaults_balance_config(balance_config *conf) {
-	conf->pitch_th = APPCONF_BALANCE_PITCH_TH;
-	conf->pitch_th_b = APPCONF_BALANCE_PITCH_TH_B;
-	conf->pitch_th_c = APPCONF_BALANCE_PITCH_TH_C;
-	conf->pitch_thi = APPCONF_BALANCE_PITCH_THI;
-	conf->pitch_thi_b = APPCONF_BALANCE_PITCH_THI_B;
-	conf->pitch_thi_c = APPCONF_BALANCE_PITCH_THI_C;
-	conf->gyro_th = APPCONF_BALANCE_GYRO_TH;
-	conf->gyro_th_b = APPCONF_BALANCE_GYRO_TH_B;
-	conf->gyro_th_c = APPCONF_BALANCE_GYRO_TH_C;
-	conf->current_out_filter = APPCONF_BALANCE_CURRENT_OUT_FILTER;
-	conf->current_out_filter_b = APPCONF_BALANCE_CURRENT_OUT_FILTER_B;
-	conf->current_out_filter_c = APPCONF_BALANCE_CURRENT_OUT_FILTER_C;
-	conf->tune_b_only_for_brakes = APPCONF_BALANCE_TUNE_B_ONLY_FOR_BRAKES;
-	conf->tune_c_only_for_brakes = APPCONF_BALANCE_TUNE_C_ONLY_FOR_BRAKES;
-	conf->brake_max_amp_change = APPCONF_BALANCE_BRAKE_MAX_AMPS;
-	conf->brake_max_amp_change_b = APPCONF_BALANCE_BRAKE_MAX_AMPS_B;
-	conf->brake_max_amp_change_c = APPCONF_BALANCE_BRAKE_MAX_AMPS_C;
-	conf->pitch_thi_limit = APPCONF_BALANCE_PITCH_THI_LIMIT;
-	conf->pitch_thi_limit_b = APPCONF_BALANCE_PITCH_THI_LIMIT_B;
-	conf->pitch_thi_limit_c = APPCONF_BALANCE_PITCH_THI_LIMIT_C;
-	conf->reset_pitch_thi_on_entering_b = APPCONF_BALANCE_RESET_PITCH_THI_ON_ENTERING_B;
-	conf->reset_pitch_thi_on_entering_c = APPCONF_BALANCE_RESET_PITCH_THI_ON_ENTERING_C;
-	conf->tunea_transition_speed = APPCONF_BALANCE_TUNEA_TRANSITION_SPEED;
-	conf->tuneb_transition_speed = APPCONF_BALANCE_TUNEB_TRANSITION_SPEED;
-	conf->tunec_transition_speed = APPCONF_BALANCE_TUNEC_TRANSITION_SPEED;
-	conf->transitions_order = APPCONF_BALANCE_TRANSITIONS_ORDER;
-	conf->tunes_mixing_b = APPCONF_BALANCE_TUNES_MIXING_B;
-	conf->tunes_mixing_c = APPCONF_BALANCE_TUNES_MIXING_C;
-	conf->asym_min_accel_b = APPCONF_BALANCE_ASYM_MIN_ACCEL_B;
-	conf->asym_max_accel_b = APPCONF_BALANCE_ASYM_MAX_ACCEL_B;
-	conf->asym_min_erpm_b = APPCONF_BALANCE_ASYM_MIN_ERPM_B;
-	conf->asym_max_erpm_b = APPCONF_BALANCE_ASYM_MAX_ERPM_B;
-	conf->asym_min_accel_c = APPCONF_BALANCE_ASYM_MIN_ACCEL_C;
-	conf->asym_max_accel_c = APPCONF_BALANCE_ASYM_MAX_ACCEL_C;
-	conf->asym_min_erpm_c = APPCONF_BALANCE_ASYM_MIN_ERPM_C;
-	conf->asym_max_erpm_c = APPCONF_BALANCE_ASYM_MAX_ERPM_C;
-	conf->mahony_kp = APPCONF_BALANCE_MAHONY_KP;
-	conf->mahony_kp_roll = APPCONF_BALANCE_MAHONY_KP_ROLL;
-	conf->mahony_kp_yaw = APPCONF_BALANCE_MAHONY_KP_YAW;
-	conf->bf_accel_confidence_decay = APPCONF_BALANCE_BF_ACCEL_CONF_DECAY;
-	conf->hertz = APPCONF_BALANCE_HERTZ;
-	conf->loop_time_filter = APPCONF_BALANCE_LOOP_TIME_FILTER;
-	conf->fault_pitch = APPCONF_BALANCE_FAULT_PITCH;
-	conf->fault_roll = APPCONF_BALANCE_FAULT_ROLL;
-	conf->fault_adc1 = APPCONF_BALANCE_FAULT_ADC1;
-	conf->fault_adc2 = APPCONF_BALANCE_FAULT_ADC2;
-	conf->fault_delay_pitch = APPCONF_BALANCE_FAULT_DELAY_PITCH;
-	conf->fault_delay_roll = APPCONF_BALANCE_FAULT_DELAY_ROLL;
-	conf->fault_delay_switch_half = APPCONF_BALANCE_FAULT_DELAY_SWITCH_HALF;
-	conf->fault_delay_switch_full = APPCONF_BALANCE_FAULT_DELAY_SWITCH_FULL;
-	conf->fault_adc_half_erpm = APPCONF_BALANCE_FAULT_ADC_HALF_ERPM;
-	conf->fault_is_single_switch = APPCONF_BALANCE_FAULT_IS_SINGLE_SWITCH;
-	conf->tiltback_duty_angle = APPCONF_BALANCE_TILTBACK_DUTY_ANGLE;
-	conf->tiltback_duty_speed = APPCONF_BALANCE_TILTBACK_DUTY_SPEED;
-	conf->tiltback_duty = APPCONF_BALANCE_TILTBACK_DUTY;
-	conf->tiltback_hv_angle = APPCONF_BALANCE_TILTBACK_HV_ANGLE;
-	conf->tiltback_hv_speed = APPCONF_BALANCE_TILTBACK_HV_SPEED;
-	conf->tiltback_hv = APPCONF_BALANCE_TILTBACK_HV;
-	conf->tiltback_lv_angle = APPCONF_BALANCE_TILTBACK_LV_ANGLE;
-	conf->tiltback_lv_speed = APPCONF_BALANCE_TILTBACK_LV_SPEED;
-	conf->tiltback_lv = APPCONF_BALANCE_TILTBACK_LV;
-	conf->tiltback_return_speed = APPCONF_BALANCE_TILTBACK_RETURN_SPEED;
-	conf->tiltback_constant = APPCONF_BALANCE_TILTBACK_CONSTANT;
-	conf->tiltback_constant_erpm = APPCONF_BALANCE_TILTBACK_CONSTANT_ERPM;
-	conf->tiltback_variable = APPCONF_BALANCE_TILTBACK_VARIABLE;
-	conf->tiltback_variable_max = APPCONF_BALANCE_TILTBACK_VARIABLE_MAX;
-	conf->tiltback_variable_start_erpm = APPCONF_BALANCE_TILTBACK_VARIABLE_START_ERPM;
-	conf->noseangling_speed = APPCONF_BALANCE_NOSEANGLING_SPEED;
-	conf->startup_pitch_tolerance = APPCONF_BALANCE_STARTUP_PITCH_TOLERANCE;
-	conf->startup_roll_tolerance = APPCONF_BALANCE_STARTUP_ROLL_TOLERANCE;
-	conf->startup_speed = APPCONF_BALANCE_STARTUP_SPEED;
-	conf->brake_current = APPCONF_BALANCE_BRAKE_CURRENT;
-	conf->torquetilt_start_current = APPCONF_BALANCE_TORQUETILT_START_CURRENT;
-	conf->torquetilt_start_current_b = APPCONF_BALANCE_TORQUETILT_START_CURRENT_B;
-	conf->torquetilt_angle_limit = APPCONF_BALANCE_TORQUETILT_ANGLE_LIMIT;
-	conf->torquetilt_on_speed = APPCONF_BALANCE_TORQUETILT_ON_SPEED;
-	conf->torquetilt_off_speed = APPCONF_BALANCE_TORQUETILT_OFF_SPEED;
-	conf->torquetilt_strength = APPCONF_BALANCE_TORQUETILT_STRENGTH;
-	conf->torquetilt_strength_regen = APPCONF_BALANCE_TORQUETILT_STRENGTH_REGEN;
-	conf->torquetilt_filter = APPCONF_BALANCE_TORQUETILT_FILTER;
-	conf->turntilt_mixing_mode = APPCONF_BALANCE_TURNTILT_MIXING_MODE;
-	conf->roll_turntilt_weight = APPCONF_BALANCE_ROLL_TURNTILT_WEIGHT;
-	conf->roll_turntilt_strength = APPCONF_BALANCE_ROLL_TURNTILT_STRENGTH;
-	conf->roll_turntilt_angle_limit = APPCONF_BALANCE_ROLL_TURNTILT_ANGLE_LIMIT;
-	conf->roll_turntilt_start_angle = APPCONF_BALANCE_ROLL_TURNTILT_START_ANGLE;
-	conf->roll_turntilt_start_erpm = APPCONF_BALANCE_ROLL_TURNTILT_START_ERPM;
-	conf->roll_turntilt_speed = APPCONF_BALANCE_ROLL_TURNTILT_SPEED;
-	conf->roll_turntilt_erpm_boost = APPCONF_BALANCE_ROLL_TURNTILT_ERPM_BOOST;
-	conf->roll_turntilt_erpm_boost_end = APPCONF_BALANCE_ROLL_TURNTILT_ERPM_BOOST_END;
-	conf->yaw_turntilt_weight = APPCONF_BALANCE_YAW_TURNTILT_WEIGHT;
-	conf->yaw_turntilt_strength = APPCONF_BALANCE_YAW_TURNTILT_STRENGTH;
-	conf->yaw_turntilt_angle_limit = APPCONF_BALANCE_YAW_TURNTILT_ANGLE_LIMIT;
-	conf->yaw_turntilt_start_angle = APPCONF_BALANCE_YAW_TURNTILT_START_ANGLE;
-	conf->yaw_turntilt_start_erpm = APPCONF_BALANCE_YAW_TURNTILT_START_ERPM;
-	conf->yaw_turntilt_speed = APPCONF_BALANCE_YAW_TURNTILT_SPEED;
-	conf->yaw_turntilt_erpm_boost = APPCONF_BALANCE_YAW_TURNTILT_ERPM_BOOST;
-	conf->yaw_turntilt_erpm_boost_end = APPCONF_BALANCE_YAW_TURNTILT_ERPM_BOOST_END;
-	conf->yaw_turntilt_aggregate = APPCONF_BALANCE_YAW_TURNTILT_AGGREGATE;
-	conf->temp_tiltback_start_offset = APPCONF_BALANCE_TEMP_TILTBACK_START;
-	conf->temp_tiltback_speed = APPCONF_BALANCE_TEMP_TILTBACK_SPEED;
-	conf->temp_tiltback_angle = APPCONF_BALANCE_TEMP_TILTBACK_ANGLE;
-	conf->enable_reverse_stop = APPCONF_BALANCE_REVERSE_STOP;
-	conf->enable_quickstop = APPCONF_BALANCE_ENABLE_QUICKSTOP;
-	conf->quickstop_erpm = APPCONF_BALANCE_QUICKSTOP_ERPM;
-	conf->quickstop_angle = APPCONF_BALANCE_QUICKSTOP_ANGLE;
-	conf->startup_click_current = APPCONF_BALANCE_STARTUP_CLICK_CURRENT;
-	conf->enable_traction_control = APPCONF_BALANCE_ENABLE_TRACTION_CONTROL;
-	conf->traction_control_mul_by = APPCONF_BALANCE_TRACTION_CONTROL_MUL_BY;
-	conf->booster_min_pitch = APPCONF_BALANCE_BOOSTER_MIN_PITCH;
-	conf->booster_max_pitch = APPCONF_BALANCE_BOOSTER_MAX_PITCH;
-	conf->booster_current_limit = APPCONF_BALANCE_BOOSTER_CURRENT_LIMIT;
-	conf->booster_min_pitch_b = APPCONF_BALANCE_BOOSTER_MIN_PITCH_B;
-	conf->booster_max_pitch_b = APPCONF_BALANCE_BOOSTER_MAX_PITCH_B;
-	conf->booster_current_limit_b = APPCONF_BALANCE_BOOSTER_CURRENT_LIMIT_B;
-	conf->booster_min_pitch_c = APPCONF_BALANCE_BOOSTER_MIN_PITCH_C;
-	conf->booster_max_pitch_c = APPCONF_BALANCE_BOOSTER_MAX_PITCH_C;
-	conf->booster_current_limit_c = APPCONF_BALANCE_BOOSTER_CURRENT_LIMIT_C;
-	conf->softstart_speed = APPCONF_BALANCE_SOFTSTART_SPEED;
+	conftable t;
+	confparser_table_balance_config(&t);
+	conftable_set_defaults(&t, conf);
 }
-
@@ -1,16 +1,141 @@
-// This file is autogenerated by VESC Tool
+// This file is autogenerated by c_libs/conftable.py from settings.xml
 
 #ifndef CONFPARSER_H_
 #define CONFPARSER_H_
 
 #include "datatypes.h"
+#include "conftable.h"
 #include <stdint.h>
 #include <stdbool.h>
 
 // Constants
 #define BALANCE_CONFIG_SIGNATURE		1334140788
 
+// Field indexes in the table from confparser_table_balance_config
+typedef enum {
+	BALANCE_CONFIG_FIELD_PITCH_TH,
+	BALANCE_CONFIG_FIELD_PITCH_TH_B,
+	BALANCE_CONFIG_FIELD_PITCH_TH_C,
+	BALANCE_CONFIG_FIELD_PITCH_THI,
+	BALANCE_CONFIG_FIELD_PITCH_THI_B,
+	BALANCE_CONFIG_FIELD_PITCH_THI_C,
+	BALANCE_CONFIG_FIELD_GYRO_TH,
+	BALANCE_CONFIG_FIELD_GYRO_TH_B,
+	BALANCE_CONFIG_FIELD_GYRO_TH_C,
+	BALANCE_CONFIG_FIELD_CURRENT_OUT_FILTER,
+	BALANCE_CONFIG_FIELD_CURRENT_OUT_FILTER_B,
+	BALANCE_CONFIG_FIELD_CURRENT_OUT_FILTER_C,
+	BALANCE_CONFIG_FIELD_TUNE_B_ONLY_FOR_BRAKES,
+	BALANCE_CONFIG_FIELD_TUNE_C_ONLY_FOR_BRAKES,
+	BALANCE_CONFIG_FIELD_BRAKE_MAX_AMP_CHANGE,
+	BALANCE_CONFIG_FIELD_BRAKE_MAX_AMP_CHANGE_B,
+	BALANCE_CONFIG_FIELD_BRAKE_MAX_AMP_CHANGE_C,
+	BALANCE_CONFIG_FIELD_PITCH_THI_LIMIT,
+	BALANCE_CONFIG_FIELD_PITCH_THI_LIMIT_B,
+	BALANCE_CONFIG_FIELD_PITCH_THI_LIMIT_C,
+	BALANCE_CONFIG_FIELD_RESET_PITCH_THI_ON_ENTERING_B,
+	BALANCE_CONFIG_FIELD_RESET_PITCH_THI_ON_ENTERING_C,
+	BALANCE_CONFIG_FIELD_TUNEA_TRANSITION_SPEED,
+	BALANCE_CONFIG_FIELD_TUNEB_TRANSITION_SPEED,
+	BALANCE_CONFIG_FIELD_TUNEC_TRANSITION_SPEED,
+	BALANCE_CONFIG_FIELD_TRANSITIONS_ORDER,
+	BALANCE_CONFIG_FIELD_TUNES_MIXING_B,
+	BALANCE_CONFIG_FIELD_TUNES_MIXING_C,
+	BALANCE_CONFIG_FIELD_ASYM_MIN_ACCEL_B,
+	BALANCE_CONFIG_FIELD_ASYM_MAX_ACCEL_B,
+	BALANCE_CONFIG_FIELD_ASYM_MIN_ERPM_B,
+	BALANCE_CONFIG_FIELD_ASYM_MAX_ERPM_B,
+	BALANCE_CONFIG_FIELD_ASYM_MIN_ACCEL_C,
+	BALANCE_CONFIG_FIELD_ASYM_MAX_ACCEL_C,
+	BALANCE_CONFIG_FIELD_ASYM_MIN_ERPM_C,
+	BALANCE_CONFIG_FIELD_ASYM_MAX_ERPM_C,
+	BALANCE_CONFIG_FIELD_MAHONY_KP,
+	BALANCE_CONFIG_FIELD_MAHONY_KP_ROLL,
+	BALANCE_CONFIG_FIELD_MAHONY_KP_YAW,
+	BALANCE_CONFIG_FIELD_BF_ACCEL_CONFIDENCE_DECAY,
+	BALANCE_CONFIG_FIELD_HERTZ,
+	BALANCE_CONFIG_FIELD_LOOP_TIME_FILTER,
+	BALANCE_CONFIG_FIELD_FAULT_PITCH,
+	BALANCE_CONFIG_FIELD_FAULT_ROLL,
+	BALANCE_CONFIG_FIELD_FAULT_ADC1,
+	BALANCE_CONFIG_FIELD_FAULT_ADC2,
+	BALANCE_CONFIG_FIELD_FAULT_DELAY_PITCH,
+	BALANCE_CONFIG_FIELD_FAULT_DELAY_ROLL,
+	BALANCE_CONFIG_FIELD_FAULT_DELAY_SWITCH_HALF,
+	BALANCE_CONFIG_FIELD_FAULT_DELAY_SWITCH_FULL,
+	BALANCE_CONFIG_FIELD_FAULT_ADC_HALF_ERPM,
+	BALANCE_CONFIG_FIELD_FAULT_IS_SINGLE_SWITCH,
+	BALANCE_CONFIG_FIELD_TILTBACK_DUTY_ANGLE,
+	BALANCE_CONFIG_FIELD_TILTBACK_DUTY_SPEED,
+	BALANCE_CONFIG_FIELD_TILTBACK_DUTY,
+	BALANCE_CONFIG_FIELD_TILTBACK_HV_ANGLE,
+	BALANCE_CONFIG_FIELD_TILTBACK_HV_SPEED,
+	BALANCE_CONFIG_FIELD_TILTBACK_HV,
+	BALANCE_CONFIG_FIELD_TILTBACK_LV_ANGLE,
+	BALANCE_CONFIG_FIELD_TILTBACK_LV_SPEED,
+	BALANCE_CONFIG_FIELD_TILTBACK_LV,
+	BALANCE_CONFIG_FIELD_TILTBACK_RETURN_SPEED,
+	BALANCE_CONFIG_FIELD_TILTBACK_CONSTANT,
+	BALANCE_CONFIG_FIELD_TILTBACK_CONSTANT_ERPM,
+	BALANCE_CONFIG_FIELD_TILTBACK_VARIABLE,
+	BALANCE_CONFIG_FIELD_TILTBACK_VARIABLE_MAX,
+	BALANCE_CONFIG_FIELD_TILTBACK_VARIABLE_START_ERPM,
+	BALANCE_CONFIG_FIELD_NOSEANGLING_SPEED,
+	BALANCE_CONFIG_FIELD_STARTUP_PITCH_TOLERANCE,
+	BALANCE_CONFIG_FIELD_STARTUP_ROLL_TOLERANCE,
+	BALANCE_CONFIG_FIELD_STARTUP_SPEED,
+	BALANCE_CONFIG_FIELD_BRAKE_CURRENT,
+	BALANCE_CONFIG_FIELD_TORQUETILT_START_CURRENT,
+	BALANCE_CONFIG_FIELD_TORQUETILT_START_CURRENT_B,
+	BALANCE_CONFIG_FIELD_TORQUETILT_ANGLE_LIMIT,
+	BALANCE_CONFIG_FIELD_TORQUETILT_ON_SPEED,
+	BALANCE_CONFIG_FIELD_TORQUETILT_OFF_SPEED,
+	BALANCE_CONFIG_FIELD_TORQUETILT_STRENGTH,
+	BALANCE_CONFIG_FIELD_TORQUETILT_STRENGTH_REGEN,
+	BALANCE_CONFIG_FIELD_TORQUETILT_FILTER,
+	BALANCE_CONFIG_FIELD_TURNTILT_MIXING_MODE,
+	BALANCE_CONFIG_FIELD_ROLL_TURNTILT_WEIGHT,
+	BALANCE_CONFIG_FIELD_ROLL_TURNTILT_STRENGTH,
+	BALANCE_CONFIG_FIELD_ROLL_TURNTILT_ANGLE_LIMIT,
+	BALANCE_CONFIG_FIELD_ROLL_TURNTILT_START_ANGLE,
+	BALANCE_CONFIG_FIELD_ROLL_TURNTILT_START_ERPM,
+	BALANCE_CONFIG_FIELD_ROLL_TURNTILT_SPEED,
+	BALANCE_CONFIG_FIELD_ROLL_TURNTILT_ERPM_BOOST,
+	BALANCE_CONFIG_FIELD_ROLL_TURNTILT_ERPM_BOOST_END,
+	BALANCE_CONFIG_FIELD_YAW_TURNTILT_WEIGHT,
+	BALANCE_CONFIG_FIELD_YAW_TURNTILT_STRENGTH,
+	BALANCE_CONFIG_FIELD_YAW_TURNTILT_ANGLE_LIMIT,
+	BALANCE_CONFIG_FIELD_YAW_TURNTILT_START_ANGLE,
+	BALANCE_CONFIG_FIELD_YAW_TURNTILT_START_ERPM,
+	BALANCE_CONFIG_FIELD_YAW_TURNTILT_SPEED,
+	BALANCE_CONFIG_FIELD_YAW_TURNTILT_ERPM_BOOST,
+	BALANCE_CONFIG_FIELD_YAW_TURNTILT_ERPM_BOOST_END,
+	BALANCE_CONFIG_FIELD_YAW_TURNTILT_AGGREGATE,
+	BALANCE_CONFIG_FIELD_TEMP_TILTBACK_START_OFFSET,
+	BALANCE_CONFIG_FIELD_TEMP_TILTBACK_SPEED,
+	BALANCE_CONFIG_FIELD_TEMP_TILTBACK_ANGLE,
+	BALANCE_CONFIG_FIELD_ENABLE_REVERSE_STOP,
+	BALANCE_CONFIG_FIELD_ENABLE_QUICKSTOP,
+	BALANCE_CONFIG_FIELD_QUICKSTOP_ERPM,
+	BALANCE_CONFIG_FIELD_QUICKSTOP_ANGLE,
+	BALANCE_CONFIG_FIELD_STARTUP_CLICK_CURRENT,
+	BALANCE_CONFIG_FIELD_ENABLE_TRACTION_CONTROL,
+	BALANCE_CONFIG_FIELD_TRACTION_CONTROL_MUL_BY,
+	BALANCE_CONFIG_FIELD_BOOSTER_MIN_PITCH,
+	BALANCE_CONFIG_FIELD_BOOSTER_MAX_PITCH,
+	BALANCE_CONFIG_FIELD_BOOSTER_CURRENT_LIMIT,
+	BALANCE_CONFIG_FIELD_BOOSTER_MIN_PITCH_B,
+	BALANCE_CONFIG_FIELD_BOOSTER_MAX_PITCH_B,
+	BALANCE_CONFIG_FIELD_BOOSTER_CURRENT_LIMIT_B,
+	BALANCE_CONFIG_FIELD_BOOSTER_MIN_PITCH_C,
+	BALANCE_CONFIG_FIELD_BOOSTER_MAX_PITCH_C,
+	BALANCE_CONFIG_FIELD_BOOSTER_CURRENT_LIMIT_C,
+	BALANCE_CONFIG_FIELD_SOFTSTART_SPEED,
+	BALANCE_CONFIG_FIELD_NUM
+} BALANCE_CONFIG_FIELD;
+
 // Functions
+void confparser_table_balance_config(conftable *t);
 int32_t confparser_serialize_balance_config(uint8_t *buffer, const balance_config *conf);
 bool confparser_deserialize_balance_config(const uint8_t *buffer, balance_config *conf);
 void confparser_set_defaults_balance_config(balance_config *conf);
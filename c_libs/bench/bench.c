@@ -0,0 +1,92 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "bench.h"
+#include "vesc_host.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define MIN_RUN_TIME		D(0.05)
+#define REPEATS				5
+
+volatile uint32_t bench_sink = 0;
+
+static double now_s(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * D(1e-9);
+}
+
+static double time_run(const bench_t *b, uint32_t iterations) {
+	if (b->setup) {
+		b->setup();
+	}
+	double start = now_s();
+	b->run(iterations);
+	double res = now_s() - start;
+	if (b->teardown) {
+		b->teardown();
+	}
+	return res;
+}
+
+static void run_bench(const bench_t *b, const char *commit, const char *filter) {
+	if (filter && !strstr(b->name, filter)) {
+		return;
+	}
+
+	// Grow the iterations until one run is long enough to time
+	uint32_t iterations = 16;
+	while (time_run(b, iterations) < MIN_RUN_TIME && iterations < (1u << 30)) {
+		iterations *= 2;
+	}
+
+	double best = D(1e9);
+	for (int i = 0;i < REPEATS;i++) {
+		double t = time_run(b, iterations);
+		if (t < best) {
+			best = t;
+		}
+	}
+
+	// One JSON object per line, so that results from many commits can be appended
+	// to the same file
+	printf("{\"commit\": \"%s\", \"bench\": \"%s\", \"ns_per_op\": %.3f, \"iterations\": %u}\n",
+			commit, b->name, best * D(1e9) / (double)iterations, iterations);
+	fflush(stdout);
+}
+
+// bench [commit] [filter]
+int main(int argc, char **argv) {
+	const char *commit = argc > 1 ? argv[1] : "unknown";
+	const char *filter = argc > 2 ? argv[2] : 0;
+
+	vesc_host_init();
+
+	const bench_t *suites[] = {bench_rb, bench_buffer, bench_balance, bench_ws2812};
+	for (unsigned int i = 0;i < sizeof(suites) / sizeof(suites[0]);i++) {
+		for (const bench_t *b = suites[i];b->name;b++) {
+			run_bench(b, commit, filter);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,49 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Microbenchmarks for the host build
+ *
+ * Each benchmark runs its operation iterations times. The runner picks the
+ * number of iterations so that a run takes a while, repeats the run and
+ * reports the fastest one as nanoseconds per operation.
+ */
+
+typedef struct {
+	const char *name;
+	void (*setup)(void);
+	void (*run)(uint32_t iterations);
+	void (*teardown)(void);
+} bench_t;
+
+// Results are written here so that the compiler cannot remove the work
+extern volatile uint32_t bench_sink;
+
+extern const bench_t bench_rb[];
+extern const bench_t bench_buffer[];
+extern const bench_t bench_balance[];
+extern const bench_t bench_ws2812[];
+
+#endif
@@ -0,0 +1,80 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "bench.h"
+
+// The biquad is static in balance_ow.c, so the whole file is built here
+#include "balance_ow.c"
+
+static balance_config conf;
+static uint8_t conf_buf[sizeof(balance_config) * 2];
+
+static void conf_setup(void) {
+	confparser_set_defaults_balance_config(&conf);
+	confparser_serialize_balance_config(conf_buf, &conf);
+}
+
+static void conf_serialize(uint32_t iterations) {
+	int32_t len = 0;
+	for (uint32_t i = 0;i < iterations;i++) {
+		len += confparser_serialize_balance_config(conf_buf, &conf);
+	}
+	bench_sink += len;
+}
+
+static void conf_deserialize(uint32_t iterations) {
+	bool ok = true;
+	for (uint32_t i = 0;i < iterations;i++) {
+		ok = confparser_deserialize_balance_config(conf_buf, &conf) && ok;
+	}
+	bench_sink += ok;
+}
+
+static void biquad(uint32_t iterations) {
+	Biquad bq;
+	biquad_config(&bq, BQ_LOWPASS, 0.05);
+	biquad_reset(&bq);
+
+	float out = 0.0;
+	for (uint32_t i = 0;i < iterations;i++) {
+		out = biquad_process(&bq, (float)(i & 63));
+	}
+	bench_sink += (uint32_t)out;
+}
+
+static void filter_update(uint32_t iterations) {
+	BalanceFilterData f;
+	balance_filter_init(&f);
+	balance_filter_configure(&f, &conf);
+
+	float gyro[3] = {0.01, -0.02, 0.005};
+	float acc[3] = {0.02, 0.01, 0.99};
+	for (uint32_t i = 0;i < iterations;i++) {
+		balance_filter_update(&f, gyro, acc, 0.001);
+	}
+	bench_sink += (uint32_t)(f.q0 * 1000.0);
+}
+
+const bench_t bench_balance[] = {
+	{"confparser_serialize_balance_config", conf_setup, conf_serialize, 0},
+	{"confparser_deserialize_balance_config", conf_setup, conf_deserialize, 0},
+	{"biquad_process", 0, biquad, 0},
+	{"balance_filter_update", conf_setup, filter_update, 0},
+	{0, 0, 0, 0}
+};
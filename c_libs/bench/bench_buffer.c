@@ -0,0 +1,83 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "bench.h"
+#include "buffer.h"
+
+#define VALUES			256
+
+static uint8_t buf[VALUES * 4];
+static float values[VALUES];
+
+// Values with a wide range of exponents, including 0 and negative values
+static void setup(void) {
+	float v = 1.0e-6;
+	for (int i = 0;i < VALUES;i++) {
+		values[i] = (i % 3) == 0 ? -v : v;
+		v *= 1.17;
+	}
+	values[0] = 0.0;
+}
+
+static void append_float32_auto(uint32_t iterations) {
+	for (uint32_t i = 0;i < iterations;i++) {
+		int32_t ind = 0;
+		buffer_append_float32_auto(buf + (i & 3) * 4, values[i % VALUES], &ind);
+	}
+	bench_sink += buf[0];
+}
+
+static void get_float32_auto(uint32_t iterations) {
+	int32_t ind = 0;
+	for (int i = 0;i < VALUES;i++) {
+		buffer_append_float32_auto(buf, values[i], &ind);
+	}
+
+	float sum = 0.0;
+	for (uint32_t i = 0;i < iterations;i++) {
+		ind = (i % VALUES) * 4;
+		sum += buffer_get_float32_auto(buf, &ind);
+	}
+	bench_sink += (uint32_t)sum;
+}
+
+static void append_float16(uint32_t iterations) {
+	for (uint32_t i = 0;i < iterations;i++) {
+		int32_t ind = (i % VALUES) * 2;
+		buffer_append_float16(buf, (float)(i % 1000), 10.0, &ind);
+	}
+	bench_sink += buf[0];
+}
+
+static void get_float16(uint32_t iterations) {
+	float sum = 0.0;
+	for (uint32_t i = 0;i < iterations;i++) {
+		int32_t ind = (i % VALUES) * 2;
+		sum += buffer_get_float16(buf, 10.0, &ind);
+	}
+	bench_sink += (uint32_t)sum;
+}
+
+const bench_t bench_buffer[] = {
+	{"buffer_append_float32_auto", setup, append_float32_auto, 0},
+	{"buffer_get_float32_auto", setup, get_float32_auto, 0},
+	{"buffer_append_float16", setup, append_float16, 0},
+	{"buffer_get_float16", setup, get_float16, 0},
+	{0, 0, 0, 0}
+};
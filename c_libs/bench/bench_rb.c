@@ -0,0 +1,76 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "bench.h"
+#include "rb.h"
+
+#define RB_ITEMS		64
+#define MULTI_ITEMS		16
+
+static rb_t rb;
+
+static void setup(void) {
+	rb_init_alloc(&rb, sizeof(uint32_t), RB_ITEMS);
+}
+
+static void teardown(void) {
+	rb_free(&rb);
+}
+
+// One insert and one pop per operation, with the buffer half full so that the
+// indexes wrap
+static void insert_pop(uint32_t iterations) {
+	uint32_t val = 0;
+	for (int i = 0;i < RB_ITEMS / 2;i++) {
+		rb_insert(&rb, &val);
+	}
+
+	for (uint32_t i = 0;i < iterations;i++) {
+		rb_insert(&rb, &i);
+		rb_pop(&rb, &val);
+	}
+
+	bench_sink += val;
+}
+
+// Insert and pop MULTI_ITEMS items with the multi-functions per operation
+static void insert_pop_multi(uint32_t iterations) {
+	uint32_t in[MULTI_ITEMS];
+	uint32_t out[MULTI_ITEMS];
+	for (int i = 0;i < MULTI_ITEMS;i++) {
+		in[i] = i;
+	}
+
+	for (int i = 0;i < RB_ITEMS / 2;i++) {
+		rb_insert(&rb, &in[0]);
+	}
+
+	for (uint32_t i = 0;i < iterations;i++) {
+		rb_insert_multi(&rb, in, MULTI_ITEMS);
+		rb_pop_multi(&rb, out, MULTI_ITEMS);
+	}
+
+	bench_sink += out[MULTI_ITEMS - 1];
+}
+
+const bench_t bench_rb[] = {
+	{"rb_insert_pop", setup, insert_pop, teardown},
+	{"rb_insert_pop_multi_16", setup, insert_pop_multi, teardown},
+	{0, 0, 0, 0}
+};
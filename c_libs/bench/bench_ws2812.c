@@ -0,0 +1,70 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "bench.h"
+#include "ws2812_encode.h"
+
+#define LEDS			300
+
+static ws2812_enc enc;
+static uint32_t colors[LEDS];
+static uint16_t bits[LEDS * 32];
+
+static void setup(void) {
+	enc.bits = 24;
+	ws2812_enc_update_lut(&enc, 50, true);
+
+	uint32_t c = 0x12345678;
+	for (int i = 0;i < LEDS;i++) {
+		c = c * 1664525 + 1013904223;
+		colors[i] = c & 0xFFFFFF;
+	}
+}
+
+// The encoding that ext-ws2812-set-color does, one call per LED
+static void per_led(uint32_t iterations) {
+	for (uint32_t i = 0;i < iterations;i++) {
+		for (int led = 0;led < LEDS;led++) {
+			ws2812_enc_color(&enc, colors[led], bits + led * enc.bits);
+		}
+	}
+	bench_sink += bits[0];
+}
+
+// The encoding that ext-ws2812-set-colors and ext-ws2812-set-palette do
+static void range(uint32_t iterations) {
+	for (uint32_t i = 0;i < iterations;i++) {
+		ws2812_enc_range(&enc, colors, LEDS, bits);
+	}
+	bench_sink += bits[0];
+}
+
+static void fill(uint32_t iterations) {
+	for (uint32_t i = 0;i < iterations;i++) {
+		ws2812_enc_fill(&enc, colors[i % LEDS], LEDS, bits);
+	}
+	bench_sink += bits[0];
+}
+
+const bench_t bench_ws2812[] = {
+	{"ws2812_per_led_300", setup, per_led, 0},
+	{"ws2812_range_300", setup, range, 0},
+	{"ws2812_fill_300", setup, fill, 0},
+	{0, 0, 0, 0}
+};
@@ -0,0 +1,52 @@
+import sys,getopt,json
+
+# Compares the last two commits in a results file from "make run". Exits with 1
+# if a benchmark got slower by more than the threshold (10% by default).
+
+threshold = 10.0
+
+opts,args = getopt.getopt(sys.argv[1:],'t:')
+for o,a in opts:
+	if o == '-t':
+		threshold = float(a)
+
+filename = args[0] if len(args) > 0 else "results.jsonl"
+
+commits = []
+results = {}
+with open(filename, "r") as f:
+	for line in f:
+		line = line.strip()
+		if not line:
+			continue
+		r = json.loads(line)
+		c = r["commit"]
+		if c not in results:
+			commits.append(c)
+			results[c] = {}
+		# The latest run of a commit wins
+		results[c][r["bench"]] = r["ns_per_op"]
+
+if len(commits) < 2:
+	print("Need results from two commits, found {}".format(len(commits)))
+	sys.exit(0)
+
+old = commits[-2]
+new = commits[-1]
+print("{} -> {}".format(old, new))
+
+slower = 0
+for name,ns in results[new].items():
+	if name not in results[old]:
+		print("  {:<40} {:>10.2f} ns (new)".format(name, ns))
+		continue
+
+	ns_old = results[old][name]
+	change = 100.0 * (ns - ns_old) / ns_old
+	mark = ""
+	if change > threshold:
+		mark = "  SLOWER"
+		slower += 1
+	print("  {:<40} {:>10.2f} ns {:>+7.1f}%{}".format(name, ns, change, mark))
+
+sys.exit(1 if slower > 0 else 0)
@@ -0,0 +1,162 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+
+// Exhaustive test of buffer_append_float32_auto and buffer_get_float32_auto
+// against the previous implementation with frexpf and ldexpf. Every finite
+// float is encoded with both and every 32-bit word is decoded with both, and
+// the results have to be identical. Takes a few minutes, so the range is split
+// over one thread per CPU.
+
+#include "buffer.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define MAX_THREADS		64
+
+static void ref_append_float32_auto(uint8_t* buffer, float number, int32_t *index) {
+	if (fabsf(number) < 1.5e-38) {
+		number = 0.0;
+	}
+
+	int e = 0;
+	float sig = frexpf(number, &e);
+	float sig_abs = fabsf(sig);
+	uint32_t sig_i = 0;
+
+	if (sig_abs >= 0.5) {
+		sig_i = (uint32_t)((sig_abs - 0.5f) * 2.0f * 8388608.0f);
+		e += 126;
+	}
+
+	uint32_t res = ((e & 0xFF) << 23) | (sig_i & 0x7FFFFF);
+	if (sig < 0) {
+		res |= 1U << 31;
+	}
+
+	buffer_append_uint32(buffer, res, index);
+}
+
+static float ref_get_float32_auto(const uint8_t *buffer, int32_t *index) {
+	uint32_t res = buffer_get_uint32(buffer, index);
+
+	int e = (res >> 23) & 0xFF;
+	uint32_t sig_i = res & 0x7FFFFF;
+	bool neg = res & (1U << 31);
+
+	float sig = 0.0;
+	if (e != 0 || sig_i != 0) {
+		sig = (float)sig_i / (8388608.0 * 2.0) + 0.5;
+		e -= 126;
+	}
+
+	if (neg) {
+		sig = -sig;
+	}
+
+	return ldexpf(sig, e);
+}
+
+typedef struct {
+	uint64_t start;
+	uint64_t end;
+	uint64_t tested;
+	uint64_t enc_errors;
+	uint64_t dec_errors;
+} job_t;
+
+static void *test_thd(void *arg) {
+	job_t *job = arg;
+
+	for (uint64_t w = job->start;w < job->end;w++) {
+		uint32_t u = (uint32_t)w;
+		buffer_float_bits fb;
+		fb.u = u;
+
+		uint8_t a[4], b[4];
+		int32_t ind_a = 0, ind_b = 0;
+
+		if (isfinite(fb.f)) {
+			ref_append_float32_auto(a, fb.f, &ind_a);
+			buffer_append_float32_auto(b, fb.f, &ind_b);
+			job->tested++;
+
+			if (ind_a != ind_b || memcmp(a, b, 4) != 0) {
+				if (job->enc_errors++ < 5) {
+					printf("Encode mismatch for 0x%08x\n", u);
+				}
+			}
+		}
+
+		ind_a = 0;
+		ind_b = 0;
+		buffer_append_uint32(a, u, &ind_a);
+		ind_a = 0;
+
+		buffer_float_bits ra, rb;
+		ra.f = ref_get_float32_auto(a, &ind_a);
+		rb.f = buffer_get_float32_auto(a, &ind_b);
+
+		if (ind_a != ind_b || (ra.u != rb.u && !(isnan(ra.f) && isnan(rb.f)))) {
+			if (job->dec_errors++ < 5) {
+				printf("Decode mismatch for 0x%08x: 0x%08x 0x%08x\n", u, ra.u, rb.u);
+			}
+		}
+	}
+
+	return 0;
+}
+
+int main(void) {
+	static job_t jobs[MAX_THREADS];
+	pthread_t threads[MAX_THREADS];
+
+	long threads_num = sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads_num < 1) {
+		threads_num = 1;
+	} else if (threads_num > MAX_THREADS) {
+		threads_num = MAX_THREADS;
+	}
+
+	uint64_t total = 1ULL << 32;
+	for (long i = 0;i < threads_num;i++) {
+		jobs[i].start = total * i / threads_num;
+		jobs[i].end = total * (i + 1) / threads_num;
+		pthread_create(&threads[i], 0, test_thd, &jobs[i]);
+	}
+
+	uint64_t tested = 0, enc_errors = 0, dec_errors = 0;
+	for (long i = 0;i < threads_num;i++) {
+		pthread_join(threads[i], 0);
+		tested += jobs[i].tested;
+		enc_errors += jobs[i].enc_errors;
+		dec_errors += jobs[i].dec_errors;
+	}
+
+	printf("float32_auto: %llu finite floats encoded, %llu words decoded, "
+			"%llu encode and %llu decode mismatches\n",
+			(unsigned long long)tested, (unsigned long long)total,
+			(unsigned long long)enc_errors, (unsigned long long)dec_errors);
+
+	return (enc_errors || dec_errors) ? 1 : 0;
+}
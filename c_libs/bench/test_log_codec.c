@@ -0,0 +1,195 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+
+// Round-trip tests of the compressed log frames in utils/log_codec.c. Frames are
+// encoded into one stream and decoded again, and every value has to come back as
+// the quantized input. Also checks that decoding can start at a key frame in the
+// middle of the stream and that broken streams are rejected.
+
+#include "log_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define FIELDS			12
+#define FRAMES			2000
+#define KEY_INTERVAL	50
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+	if (!(cond)) { \
+		if (failures++ < 10) { \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	}
+
+static float rand_float(float min, float max) {
+	return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+// Value that the decoder should return for value
+static float expected(float value, float scale) {
+	float q = roundf(value * scale);
+	if (!(q > -2147483520.0) || !(q < 2147483520.0)) {
+		q = q > 0.0 ? (float)INT32_MAX : (q < 0.0 ? (float)INT32_MIN : 0.0);
+	}
+
+	return (float)(int32_t)q / scale;
+}
+
+// A log with fast signals, slow signals that are repeated and counters
+static void make_frames(float frames[FRAMES][FIELDS]) {
+	float temp = 30.0, ah = 0.0;
+
+	for (int f = 0;f < FRAMES;f++) {
+		float *v = frames[f];
+
+		temp += rand_float(-0.01, 0.02);
+		ah += rand_float(0.0, 0.0005);
+
+		v[0] = 48.0 + rand_float(-2.0, 2.0); // Voltage
+		v[1] = rand_float(-150.0, 150.0); // Current
+		v[2] = rand_float(-1.0, 1.0); // Duty
+		v[3] = rand_float(-40000.0, 40000.0); // RPM
+		v[4] = temp;
+		v[5] = temp + 10.0;
+		v[6] = ah;
+		v[7] = ah * 48.0;
+		v[8] = 0.0; // Fault
+		v[9] = (float)f * 0.01; // Time
+		v[10] = rand_float(-3.2, 3.2); // Pitch
+		v[11] = f % 100 == 0 ? rand_float(-1.0e6, 1.0e6) : 0.0; // Spikes
+	}
+}
+
+static void test_round_trip(void) {
+	static float frames[FRAMES][FIELDS];
+	static uint8_t stream[FRAMES * LOG_CODEC_MAX_LEN(FIELDS)];
+	make_frames(frames);
+
+	float scale[FIELDS];
+	int32_t prev_enc[FIELDS], prev_dec[FIELDS];
+	for (int i = 0;i < FIELDS;i++) {
+		scale[i] = powf(10.0, (float)(i % 4));
+	}
+
+	log_codec_t enc, dec;
+	log_codec_init(&enc, FIELDS, scale, prev_enc, KEY_INTERVAL);
+	log_codec_init(&dec, FIELDS, scale, prev_dec, KEY_INTERVAL);
+
+	int32_t len = 0;
+	int32_t key_pos = -1;
+	for (int f = 0;f < FRAMES;f++) {
+		int32_t start = len;
+		int32_t n = log_codec_append_frame(&enc, frames[f], stream, &len);
+		CHECK(n == len - start && n <= LOG_CODEC_MAX_LEN(FIELDS), "Frame %d has invalid length %d", f, n);
+		CHECK((stream[start] == LOG_CODEC_KEY) == (f % KEY_INTERVAL == 0), "Frame %d has the wrong header", f);
+
+		if (f == KEY_INTERVAL * 3) {
+			key_pos = start;
+		}
+	}
+
+	int32_t ind = 0;
+	float values[FIELDS];
+	for (int f = 0;f < FRAMES;f++) {
+		CHECK(log_codec_get_frame(&dec, stream, len, &ind, values), "Could not decode frame %d", f);
+		for (int i = 0;i < FIELDS;i++) {
+			float exp = expected(frames[f][i], scale[i]);
+			CHECK(values[i] == exp, "Frame %d field %d: %g, expected %g", f, i, (double)values[i], (double)exp);
+		}
+	}
+	CHECK(ind == len, "Decoded %d of %d bytes", ind, len);
+
+	// Start in the middle of the stream at a key frame
+	log_codec_init(&dec, FIELDS, scale, prev_dec, KEY_INTERVAL);
+	ind = key_pos;
+	for (int f = KEY_INTERVAL * 3;f < FRAMES;f++) {
+		CHECK(log_codec_get_frame(&dec, stream, len, &ind, values), "Could not decode frame %d from key frame", f);
+		for (int i = 0;i < FIELDS;i++) {
+			CHECK(values[i] == expected(frames[f][i], scale[i]), "Frame %d field %d differs from key frame", f, i);
+		}
+	}
+
+	// A delta frame without a key frame before it can not be decoded
+	log_codec_init(&dec, FIELDS, scale, prev_dec, KEY_INTERVAL);
+	ind = 0;
+	log_codec_get_frame(&dec, stream, len, &ind, values);
+	int32_t delta_pos = ind;
+	log_codec_init(&dec, FIELDS, scale, prev_dec, KEY_INTERVAL);
+	CHECK(!log_codec_get_frame(&dec, stream, len, &delta_pos, values), "Delta frame decoded without key frame");
+
+	// Truncated frames are rejected
+	log_codec_init(&dec, FIELDS, scale, prev_dec, KEY_INTERVAL);
+	ind = 0;
+	CHECK(!log_codec_get_frame(&dec, stream, 3, &ind, values), "Truncated frame decoded");
+
+	printf("log_codec: %d frames with %d fields, %d bytes, %.2f bytes per field instead of 4\n",
+			FRAMES, FIELDS, len, (double)len / (double)(FRAMES * FIELDS));
+}
+
+static void test_limits(void) {
+	float scale[4] = {1.0, 100.0, 1000.0, 1.0};
+	float in[4] = {NAN, 3.0e9, -3.0e9, -2147483648.0};
+	int32_t prev_enc[4], prev_dec[4];
+	uint8_t stream[3 * LOG_CODEC_MAX_LEN(4)];
+
+	log_codec_t enc, dec;
+	log_codec_init(&enc, 4, scale, prev_enc, 0);
+	log_codec_init(&dec, 4, scale, prev_dec, 0);
+
+	// The second frame goes from INT32_MIN to INT32_MAX and back, which only
+	// works if the differences wrap around.
+	float frames[3][4] = {
+			{in[0], in[1], in[2], in[3]},
+			{in[0], in[2], in[1], 2147483520.0},
+			{in[0], in[1], in[2], in[3]},
+	};
+
+	int32_t len = 0;
+	for (int f = 0;f < 3;f++) {
+		log_codec_append_frame(&enc, frames[f], stream, &len);
+	}
+
+	int32_t ind = 0;
+	float values[4];
+	for (int f = 0;f < 3;f++) {
+		CHECK(log_codec_get_frame(&dec, stream, len, &ind, values), "Could not decode limit frame %d", f);
+		for (int i = 0;i < 4;i++) {
+			float exp = expected(frames[f][i], scale[i]);
+			CHECK(values[i] == exp, "Limit frame %d field %d: %g, expected %g", f, i, (double)values[i], (double)exp);
+		}
+	}
+
+	CHECK(values[0] == 0.0, "NaN is not decoded as 0");
+}
+
+int main(void) {
+	srand(1234);
+
+	test_round_trip();
+	test_limits();
+
+	printf("log_codec: %d failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+import sys,getopt,re
+import xml.etree.ElementTree as ET
+
+# Generates confparser.c and confparser.h with a descriptor table for
+# utils/conftable.c from the settings.xml of a package, instead of the one line
+# per field code that VESC Tool generates. The functions have the same names
+# and the same format on the wire, so the package code does not change. Run it
+# after generating the config files in VESC Tool, e.g.
+#
+# python3 ../../c_libs/conftable.py -f conf/settings.xml -o conf/confparser
+#
+# The signature is calculated by VESC Tool and read from the confparser.h that
+# it generated, unless it is given with -s.
+
+filename = ""
+out = "confparser"
+signature = None
+
+opts,args = getopt.getopt(sys.argv[1:],'f:o:s:')
+for o,a in opts:
+	if o == '-f':
+		filename = a
+	if o == '-o':
+		out = a
+	if o == '-s':
+		signature = int(a, 0)
+
+root = ET.parse(filename).getroot()
+params = root.find("Params")
+
+def text(p, tag, default = ""):
+	e = p.find(tag)
+	if e is None or e.text is None:
+		return default
+	return e.text.strip()
+
+conf_name = text(params.find("config_name"), "valString")
+conf_upper = conf_name.upper()
+
+if signature is None:
+	with open(out + ".h", "r") as f:
+		m = re.search(r'#define\s+' + conf_upper + r'_SIGNATURE\s+(\w+)', f.read())
+		if not m:
+			sys.exit("No signature found in " + out + ".h, give it with -s")
+		signature = int(m.group(1), 0)
+
+# VESC Tool parameter types and transmit types
+TYPE_DOUBLE = 1
+TYPE_INT = 2
+TYPE_ENUM = 4
+TYPE_BOOL = 5
+
+int_tx = {1: "U8", 2: "I8", 3: "U16", 4: "I16", 5: "U32", 6: "I32"}
+double_tx = {7: "F16", 8: "F32", 9: "F32_AUTO"}
+
+entries = []
+names = []
+for s in root.find("SerOrder").findall("ser"):
+	name = s.text.strip()
+	p = params.find(name)
+	if p is None:
+		sys.exit("Parameter " + name + " is missing")
+
+	ptype = int(text(p, "type"))
+	tx = int(text(p, "vTx", "0"))
+	define = text(p, "cDefine")
+
+	if ptype == TYPE_DOUBLE and tx in double_tx:
+		t = double_tx[tx]
+		scale = text(p, "vTxDoubleScale", "1") if t != "F32_AUTO" else "0.0"
+		entries.append("CONFTABLE_FLOAT(%s, %s, CONFTABLE_%s, %s, %s)" % (conf_name, name, t, scale, define))
+	elif ptype == TYPE_INT and tx in int_tx:
+		entries.append("CONFTABLE_INT(%s, %s, CONFTABLE_%s, %s)" % (conf_name, name, int_tx[tx], define))
+	elif ptype == TYPE_ENUM:
+		entries.append("CONFTABLE_INT(%s, %s, CONFTABLE_U8, %s)" % (conf_name, name, define))
+	elif ptype == TYPE_BOOL:
+		entries.append("CONFTABLE_INT(%s, %s, CONFTABLE_BOOL, %s)" % (conf_name, name, define))
+	else:
+		sys.exit("Unsupported type %d with vTx %d for %s" % (ptype, tx, name))
+
+	names.append(name)
+
+header = "// This file is autogenerated by c_libs/conftable.py from " + filename.split("/")[-1] + "\n\n"
+
+src = header
+src += '#include "conf_general.h"\n'
+src += '#include "confparser.h"\n\n'
+src += "static const conftable_field fields[] = {\n"
+src += "".join("\t" + e + ",\n" for e in entries)
+src += "};\n\n"
+# The table is built on the stack, as a pointer to fields in static data would
+# keep its address from link time.
+src += "void confparser_table_%s(conftable *t) {\n" % conf_name
+src += "\tt->signature = %s_SIGNATURE;\n" % conf_upper
+src += "\tt->fields = fields;\n"
+src += "\tt->field_num = %s_FIELD_NUM;\n" % conf_upper
+src += "}\n\n"
+src += "int32_t confparser_serialize_%s(uint8_t *buffer, const %s *conf) {\n" % (conf_name, conf_name)
+src += "\tconftable t;\n"
+src += "\tconfparser_table_%s(&t);\n" % conf_name
+src += "\treturn conftable_serialize(&t, buffer, conf);\n"
+src += "}\n\n"
+src += "bool confparser_deserialize_%s(const uint8_t *buffer, %s *conf) {\n" % (conf_name, conf_name)
+src += "\tconftable t;\n"
+src += "\tconfparser_table_%s(&t);\n" % conf_name
+src += "\treturn conftable_deserialize(&t, buffer, conf, NULL);\n"
+src += "}\n\n"
+src += "void confparser_set_defaults_%s(%s *conf) {\n" % (conf_name, conf_name)
+src += "\tconftable t;\n"
+src += "\tconfparser_table_%s(&t);\n" % conf_name
+src += "\tconftable_set_defaults(&t, conf);\n"
+src += "}\n"
+
+hdr = header
+hdr += "#ifndef CONFPARSER_H_\n"
+hdr += "#define CONFPARSER_H_\n\n"
+hdr += '#include "datatypes.h"\n'
+hdr += '#include "conftable.h"\n'
+hdr += "#include <stdint.h>\n"
+hdr += "#include <stdbool.h>\n\n"
+hdr += "// Constants\n"
+hdr += "#define %s_SIGNATURE\t\t%d\n\n" % (conf_upper, signature)
+hdr += "// Field indexes in the table from confparser_table_%s\n" % conf_name
+hdr += "typedef enum {\n"
+hdr += "".join("\t%s_FIELD_%s,\n" % (conf_upper, n.upper()) for n in names)
+hdr += "\t%s_FIELD_NUM\n" % conf_upper
+hdr += "} %s_FIELD;\n\n" % conf_upper
+hdr += "// Functions\n"
+hdr += "void confparser_table_%s(conftable *t);\n" % conf_name
+hdr += "int32_t confparser_serialize_%s(uint8_t *buffer, const %s *conf);\n" % (conf_name, conf_name)
+hdr += "bool confparser_deserialize_%s(const uint8_t *buffer, %s *conf);\n" % (conf_name, conf_name)
+hdr += "void confparser_set_defaults_%s(%s *conf);\n\n" % (conf_name, conf_name)
+hdr += "// CONFPARSER_H_\n"
+hdr += "#endif\n"
+
+with open(out + ".c", "w") as f:
+	f.write(src)
+
+with open(out + ".h", "w") as f:
+	f.write(hdr)
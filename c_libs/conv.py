@@ -1,32 +1,41 @@
-import sys,getopt,binascii
+import sys,getopt
 
 filename = ""
 name = "test"
+decimal = False
+per_line = 20
 
-opts,args = getopt.getopt(sys.argv[1:],'f:n:')
+# -d writes the bytes as decimal numbers, which makes the output about 30%
+# smaller than with hex. Note that importing the .bin directly in the package
+# is smaller still, as that stores one byte per byte.
+opts,args = getopt.getopt(sys.argv[1:],'f:n:dw:')
 for o,a in opts:
 	if o == '-f':
 		filename = a
 	if o == '-n':
 		name = a
+	if o == '-d':
+		decimal = True
+	if o == '-w':
+		per_line = int(a)
 
 with open(filename, "rb") as f:
-	hexdata = f.read().hex()
-	tokens = [hexdata[i:i+2] for i in range(0, len(hexdata), 2)]
-	res = "(def " + name + " [\n"
-	cnt = 0
-	for c in tokens:
-		res += "0x" + c
-		cnt = cnt + 1
-		if cnt == 20:
-			cnt = 0
-			res += "\n"
-		else:
-			res += " "
-	
-	if res[-1] == '\n':
-		res += "])\n"
-	else:
-		res += "\n])\n"
-	print(res)
+	data = f.read()
 
+if decimal:
+	tokens = [str(b) for b in data]
+else:
+	tokens = ["0x%02x" % b for b in data]
+
+# The lines are joined once at the end, so that this is linear in the size
+lines = [" ".join(tokens[i:i + per_line]) for i in range(0, len(tokens), per_line)]
+res = "(def " + name + " [\n" + "\n".join(lines)
+
+if len(tokens) == 0:
+	res += "])\n"
+elif len(tokens) % per_line == 0:
+	res += "\n])\n"
+else:
+	res += " \n])\n"
+
+print(res)
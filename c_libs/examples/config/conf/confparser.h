@@ -1,16 +1,92 @@
-// This file is autogenerated by VESC Tool
+// This file is autogenerated by c_libs/conftable.py from settings.xml
 
 #ifndef CONFPARSER_H_
 #define CONFPARSER_H_
 
 #include "datatypes.h"
+#include "conftable.h"
 #include <stdint.h>
 #include <stdbool.h>
 
 // Constants
 #define BALANCE_CONFIG_SIGNATURE		32903057
 
+// Field indexes in the table from confparser_table_balance_config
+typedef enum {
+	BALANCE_CONFIG_FIELD_PID_MODE,
+	BALANCE_CONFIG_FIELD_KP,
+	BALANCE_CONFIG_FIELD_KI,
+	BALANCE_CONFIG_FIELD_KD,
+	BALANCE_CONFIG_FIELD_KP2,
+	BALANCE_CONFIG_FIELD_KI2,
+	BALANCE_CONFIG_FIELD_KD2,
+	BALANCE_CONFIG_FIELD_HERTZ,
+	BALANCE_CONFIG_FIELD_LOOP_TIME_FILTER,
+	BALANCE_CONFIG_FIELD_FAULT_PITCH,
+	BALANCE_CONFIG_FIELD_FAULT_ROLL,
+	BALANCE_CONFIG_FIELD_FAULT_DUTY,
+	BALANCE_CONFIG_FIELD_FAULT_ADC1,
+	BALANCE_CONFIG_FIELD_FAULT_ADC2,
+	BALANCE_CONFIG_FIELD_FAULT_DELAY_PITCH,
+	BALANCE_CONFIG_FIELD_FAULT_DELAY_ROLL,
+	BALANCE_CONFIG_FIELD_FAULT_DELAY_DUTY,
+	BALANCE_CONFIG_FIELD_FAULT_DELAY_SWITCH_HALF,
+	BALANCE_CONFIG_FIELD_FAULT_DELAY_SWITCH_FULL,
+	BALANCE_CONFIG_FIELD_FAULT_ADC_HALF_ERPM,
+	BALANCE_CONFIG_FIELD_FAULT_IS_DUAL_SWITCH,
+	BALANCE_CONFIG_FIELD_TILTBACK_DUTY_ANGLE,
+	BALANCE_CONFIG_FIELD_TILTBACK_DUTY_SPEED,
+	BALANCE_CONFIG_FIELD_TILTBACK_DUTY,
+	BALANCE_CONFIG_FIELD_TILTBACK_HV_ANGLE,
+	BALANCE_CONFIG_FIELD_TILTBACK_HV_SPEED,
+	BALANCE_CONFIG_FIELD_TILTBACK_HV,
+	BALANCE_CONFIG_FIELD_TILTBACK_LV_ANGLE,
+	BALANCE_CONFIG_FIELD_TILTBACK_LV_SPEED,
+	BALANCE_CONFIG_FIELD_TILTBACK_LV,
+	BALANCE_CONFIG_FIELD_TILTBACK_RETURN_SPEED,
+	BALANCE_CONFIG_FIELD_TILTBACK_CONSTANT,
+	BALANCE_CONFIG_FIELD_TILTBACK_CONSTANT_ERPM,
+	BALANCE_CONFIG_FIELD_TILTBACK_VARIABLE,
+	BALANCE_CONFIG_FIELD_TILTBACK_VARIABLE_MAX,
+	BALANCE_CONFIG_FIELD_NOSEANGLING_SPEED,
+	BALANCE_CONFIG_FIELD_STARTUP_PITCH_TOLERANCE,
+	BALANCE_CONFIG_FIELD_STARTUP_ROLL_TOLERANCE,
+	BALANCE_CONFIG_FIELD_STARTUP_SPEED,
+	BALANCE_CONFIG_FIELD_DEADZONE,
+	BALANCE_CONFIG_FIELD_MULTI_ESC,
+	BALANCE_CONFIG_FIELD_YAW_KP,
+	BALANCE_CONFIG_FIELD_YAW_KI,
+	BALANCE_CONFIG_FIELD_YAW_KD,
+	BALANCE_CONFIG_FIELD_ROLL_STEER_KP,
+	BALANCE_CONFIG_FIELD_ROLL_STEER_ERPM_KP,
+	BALANCE_CONFIG_FIELD_BRAKE_CURRENT,
+	BALANCE_CONFIG_FIELD_BRAKE_TIMEOUT,
+	BALANCE_CONFIG_FIELD_YAW_CURRENT_CLAMP,
+	BALANCE_CONFIG_FIELD_KD_PT1_LOWPASS_FREQUENCY,
+	BALANCE_CONFIG_FIELD_KD_PT1_HIGHPASS_FREQUENCY,
+	BALANCE_CONFIG_FIELD_KD_BIQUAD_LOWPASS,
+	BALANCE_CONFIG_FIELD_KD_BIQUAD_HIGHPASS,
+	BALANCE_CONFIG_FIELD_BOOSTER_ANGLE,
+	BALANCE_CONFIG_FIELD_BOOSTER_RAMP,
+	BALANCE_CONFIG_FIELD_BOOSTER_CURRENT,
+	BALANCE_CONFIG_FIELD_TORQUETILT_START_CURRENT,
+	BALANCE_CONFIG_FIELD_TORQUETILT_ANGLE_LIMIT,
+	BALANCE_CONFIG_FIELD_TORQUETILT_ON_SPEED,
+	BALANCE_CONFIG_FIELD_TORQUETILT_OFF_SPEED,
+	BALANCE_CONFIG_FIELD_TORQUETILT_STRENGTH,
+	BALANCE_CONFIG_FIELD_TORQUETILT_FILTER,
+	BALANCE_CONFIG_FIELD_TURNTILT_STRENGTH,
+	BALANCE_CONFIG_FIELD_TURNTILT_ANGLE_LIMIT,
+	BALANCE_CONFIG_FIELD_TURNTILT_START_ANGLE,
+	BALANCE_CONFIG_FIELD_TURNTILT_START_ERPM,
+	BALANCE_CONFIG_FIELD_TURNTILT_SPEED,
+	BALANCE_CONFIG_FIELD_TURNTILT_ERPM_BOOST,
+	BALANCE_CONFIG_FIELD_TURNTILT_ERPM_BOOST_END,
+	BALANCE_CONFIG_FIELD_NUM
+} BALANCE_CONFIG_FIELD;
+
 // Functions
+void confparser_table_balance_config(conftable *t);
 int32_t confparser_serialize_balance_config(uint8_t *buffer, const balance_config *conf);
 bool confparser_deserialize_balance_config(const uint8_t *buffer, balance_config *conf);
 void confparser_set_defaults_balance_config(balance_config *conf);
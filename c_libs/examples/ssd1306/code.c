@@ -17,10 +17,164 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "st_types.h"
 #include "vesc_c_if.h"
+#include "i2c_bb.h"
+
+#include <string.h>
 
 HEADER
 
+// The display is 128x64 pixels in 8 pages of 8 rows. Each byte is one column
+// of 8 pixels in a page with the LSB at the top, which is the layout that the
+// SSD1306 uses in horizontal addressing mode.
+#define DISP_W			128
+#define DISP_H			64
+#define DISP_PAGES		(DISP_H / 8)
+#define FB_SIZE			(DISP_W * DISP_PAGES)
+
+// The framebuffer is sent with one I2C transaction that starts with the data
+// control byte, so it is stored right before the pixels. The pixels are word
+// aligned so that spans can be drawn 4 columns at a time.
+#define CTRL_DATA		0x40
+
+// I2C
+#define I2C_ADDR_DEFAULT	0x3C
+#define I2C_RATE			400000
+#define CTRL_CMD			0x00
+
+// Windows on neighbouring pages are merged when that sends at most this many
+// extra bytes. Every window costs a command transaction of about that size.
+#define MERGE_MAX_EXTRA		8
+
+// Font
+#define FONT_W			5
+#define FONT_FIRST		32
+#define FONT_LAST		126
+
+typedef enum {
+	COLOR_BLACK = 0,
+	COLOR_WHITE,
+	COLOR_INVERT
+} Color;
+
+// Framebuffer with the columns that have changed in each page since the last
+// flush. A page is clean when dirty_x0 > dirty_x1.
+typedef struct {
+	uint8_t *pix;
+	uint8_t dirty_x0[DISP_PAGES];
+	uint8_t dirty_x1[DISP_PAGES];
+} fb_t;
+
+typedef struct {
+	uint8_t *mem;
+	fb_t fb;
+	i2c_bb_state i2c;
+	uint16_t i2c_addr;
+	bool i2c_ok;
+} data;
+
+// 5x7 ASCII font from 32 to 126, one byte per column with the LSB at the top.
+// The columns are in the same format as the framebuffer, so the glyphs can be
+// drawn with blit.
+static const uint8_t font5x7[(FONT_LAST - FONT_FIRST + 1) * FONT_W] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, //
+	0x00, 0x00, 0x5F, 0x00, 0x00, // !
+	0x00, 0x07, 0x00, 0x07, 0x00, // "
+	0x14, 0x7F, 0x14, 0x7F, 0x14, // #
+	0x24, 0x2A, 0x7F, 0x2A, 0x12, // $
+	0x23, 0x13, 0x08, 0x64, 0x62, // %
+	0x36, 0x49, 0x55, 0x22, 0x50, // &
+	0x00, 0x05, 0x03, 0x00, 0x00, // '
+	0x00, 0x1C, 0x22, 0x41, 0x00, // (
+	0x00, 0x41, 0x22, 0x1C, 0x00, // )
+	0x08, 0x2A, 0x1C, 0x2A, 0x08, // *
+	0x08, 0x08, 0x3E, 0x08, 0x08, // +
+	0x00, 0x50, 0x30, 0x00, 0x00, // ,
+	0x08, 0x08, 0x08, 0x08, 0x08, // -
+	0x00, 0x60, 0x60, 0x00, 0x00, // .
+	0x20, 0x10, 0x08, 0x04, 0x02, // /
+	0x3E, 0x51, 0x49, 0x45, 0x3E, // 0
+	0x00, 0x42, 0x7F, 0x40, 0x00, // 1
+	0x42, 0x61, 0x51, 0x49, 0x46, // 2
+	0x21, 0x41, 0x45, 0x4B, 0x31, // 3
+	0x18, 0x14, 0x12, 0x7F, 0x10, // 4
+	0x27, 0x45, 0x45, 0x45, 0x39, // 5
+	0x3C, 0x4A, 0x49, 0x49, 0x30, // 6
+	0x01, 0x71, 0x09, 0x05, 0x03, // 7
+	0x36, 0x49, 0x49, 0x49, 0x36, // 8
+	0x06, 0x49, 0x49, 0x29, 0x1E, // 9
+	0x00, 0x36, 0x36, 0x00, 0x00, // :
+	0x00, 0x56, 0x36, 0x00, 0x00, // ;
+	0x08, 0x14, 0x22, 0x41, 0x00, // <
+	0x14, 0x14, 0x14, 0x14, 0x14, // =
+	0x00, 0x41, 0x22, 0x14, 0x08, // >
+	0x02, 0x01, 0x51, 0x09, 0x06, // ?
+	0x32, 0x49, 0x79, 0x41, 0x3E, // @
+	0x7E, 0x11, 0x11, 0x11, 0x7E, // A
+	0x7F, 0x49, 0x49, 0x49, 0x36, // B
+	0x3E, 0x41, 0x41, 0x41, 0x22, // C
+	0x7F, 0x41, 0x41, 0x22, 0x1C, // D
+	0x7F, 0x49, 0x49, 0x49, 0x41, // E
+	0x7F, 0x09, 0x09, 0x09, 0x01, // F
+	0x3E, 0x41, 0x49, 0x49, 0x7A, // G
+	0x7F, 0x08, 0x08, 0x08, 0x7F, // H
+	0x00, 0x41, 0x7F, 0x41, 0x00, // I
+	0x20, 0x40, 0x41, 0x3F, 0x01, // J
+	0x7F, 0x08, 0x14, 0x22, 0x41, // K
+	0x7F, 0x40, 0x40, 0x40, 0x40, // L
+	0x7F, 0x02, 0x0C, 0x02, 0x7F, // M
+	0x7F, 0x04, 0x08, 0x10, 0x7F, // N
+	0x3E, 0x41, 0x41, 0x41, 0x3E, // O
+	0x7F, 0x09, 0x09, 0x09, 0x06, // P
+	0x3E, 0x41, 0x51, 0x21, 0x5E, // Q
+	0x7F, 0x09, 0x19, 0x29, 0x46, // R
+	0x46, 0x49, 0x49, 0x49, 0x31, // S
+	0x01, 0x01, 0x7F, 0x01, 0x01, // T
+	0x3F, 0x40, 0x40, 0x40, 0x3F, // U
+	0x1F, 0x20, 0x40, 0x20, 0x1F, // V
+	0x3F, 0x40, 0x38, 0x40, 0x3F, // W
+	0x63, 0x14, 0x08, 0x14, 0x63, // X
+	0x07, 0x08, 0x70, 0x08, 0x07, // Y
+	0x61, 0x51, 0x49, 0x45, 0x43, // Z
+	0x00, 0x7F, 0x41, 0x41, 0x00, // [
+	0x02, 0x04, 0x08, 0x10, 0x20, // backslash
+	0x00, 0x41, 0x41, 0x7F, 0x00, // ]
+	0x04, 0x02, 0x01, 0x02, 0x04, // ^
+	0x40, 0x40, 0x40, 0x40, 0x40, // _
+	0x00, 0x01, 0x02, 0x04, 0x00, // `
+	0x20, 0x54, 0x54, 0x54, 0x78, // a
+	0x7F, 0x48, 0x44, 0x44, 0x38, // b
+	0x38, 0x44, 0x44, 0x44, 0x20, // c
+	0x38, 0x44, 0x44, 0x48, 0x7F, // d
+	0x38, 0x54, 0x54, 0x54, 0x18, // e
+	0x08, 0x7E, 0x09, 0x01, 0x02, // f
+	0x0C, 0x52, 0x52, 0x52, 0x3E, // g
+	0x7F, 0x08, 0x04, 0x04, 0x78, // h
+	0x00, 0x44, 0x7D, 0x40, 0x00, // i
+	0x20, 0x40, 0x44, 0x3D, 0x00, // j
+	0x7F, 0x10, 0x28, 0x44, 0x00, // k
+	0x00, 0x41, 0x7F, 0x40, 0x00, // l
+	0x7C, 0x04, 0x18, 0x04, 0x78, // m
+	0x7C, 0x08, 0x04, 0x04, 0x78, // n
+	0x38, 0x44, 0x44, 0x44, 0x38, // o
+	0x7C, 0x14, 0x14, 0x14, 0x08, // p
+	0x08, 0x14, 0x14, 0x18, 0x7C, // q
+	0x7C, 0x08, 0x04, 0x04, 0x08, // r
+	0x48, 0x54, 0x54, 0x54, 0x20, // s
+	0x04, 0x3F, 0x44, 0x40, 0x20, // t
+	0x3C, 0x40, 0x40, 0x20, 0x7C, // u
+	0x1C, 0x20, 0x40, 0x20, 0x1C, // v
+	0x3C, 0x40, 0x30, 0x40, 0x3C, // w
+	0x44, 0x28, 0x10, 0x28, 0x44, // x
+	0x0C, 0x50, 0x50, 0x50, 0x3C, // y
+	0x44, 0x64, 0x54, 0x4C, 0x44, // z
+	0x00, 0x08, 0x36, 0x41, 0x00, // {
+	0x00, 0x00, 0x7F, 0x00, 0x00, // |
+	0x00, 0x41, 0x36, 0x08, 0x00, // }
+	0x08, 0x04, 0x08, 0x10, 0x08, // ~
+};
+
 static int abs(int x) {
 	if (x >= 0) {
 		return x;
@@ -29,17 +183,122 @@ static int abs(int x) {
 	}
 }
 
-static void set_pix(uint8_t *arr, int x, int y) {
-	if (x < 0 || x >= 128 || y < 0 || y >= 64) {
+static inline void mark_dirty(fb_t *fb, int page, int x0, int x1) {
+	if (x0 < fb->dirty_x0[page]) {
+		fb->dirty_x0[page] = x0;
+	}
+	if (x1 > fb->dirty_x1[page]) {
+		fb->dirty_x1[page] = x1;
+	}
+}
+
+static void mark_clean(fb_t *fb) {
+	memset(fb->dirty_x0, 0xFF, DISP_PAGES);
+	memset(fb->dirty_x1, 0, DISP_PAGES);
+}
+
+static void mark_all(fb_t *fb) {
+	memset(fb->dirty_x0, 0, DISP_PAGES);
+	memset(fb->dirty_x1, DISP_W - 1, DISP_PAGES);
+}
+
+static inline void apply_u8(uint8_t *p, uint8_t mask, Color color) {
+	switch (color) {
+	case COLOR_BLACK: *p &= ~mask; break;
+	case COLOR_WHITE: *p |= mask; break;
+	default: *p ^= mask; break;
+	}
+}
+
+// Applies mask to the columns x0 to x1 in page. The columns between the first
+// and the last aligned word are done 4 at a time.
+static void fill_mask(fb_t *fb, int page, int x0, int x1, uint8_t mask, Color color) {
+	mark_dirty(fb, page, x0, x1);
+
+	uint8_t *p = fb->pix + page * DISP_W + x0;
+	int n = x1 - x0 + 1;
+
+	while (n > 0 && ((uintptr_t)p & 3)) {
+		apply_u8(p++, mask, color);
+		n--;
+	}
+
+	uint32_t *w = (uint32_t*)p;
+	uint32_t mask32 = (uint32_t)mask * 0x01010101;
+
+	switch (color) {
+	case COLOR_BLACK:
+		for (;n >= 4;n -= 4) {
+			*w++ &= ~mask32;
+		}
+		break;
+	case COLOR_WHITE:
+		for (;n >= 4;n -= 4) {
+			*w++ |= mask32;
+		}
+		break;
+	default:
+		for (;n >= 4;n -= 4) {
+			*w++ ^= mask32;
+		}
+		break;
+	}
+
+	p = (uint8_t*)w;
+	while (n > 0) {
+		apply_u8(p++, mask, color);
+		n--;
+	}
+}
+
+// Fills the rectangle with the corners (x0, y0) and (x1, y1), both inclusive.
+// All other primitives except for blit end up here.
+static void fill_rect(fb_t *fb, int x0, int y0, int x1, int y1, Color color) {
+	if (x0 > x1) {
+		int tmp = x0; x0 = x1; x1 = tmp;
+	}
+	if (y0 > y1) {
+		int tmp = y0; y0 = y1; y1 = tmp;
+	}
+
+	if (x1 < 0 || x0 >= DISP_W || y1 < 0 || y0 >= DISP_H) {
+		return;
+	}
+
+	if (x0 < 0) x0 = 0;
+	if (y0 < 0) y0 = 0;
+	if (x1 >= DISP_W) x1 = DISP_W - 1;
+	if (y1 >= DISP_H) y1 = DISP_H - 1;
+
+	int p0 = y0 >> 3;
+	int p1 = y1 >> 3;
+	for (int p = p0;p <= p1;p++) {
+		uint8_t mask = 0xFF;
+		if (p == p0) {
+			mask &= 0xFF << (y0 & 7);
+		}
+		if (p == p1) {
+			mask &= 0xFF >> (7 - (y1 & 7));
+		}
+		fill_mask(fb, p, x0, x1, mask, color);
+	}
+}
+
+static inline void set_pix(fb_t *fb, int x, int y, Color color) {
+	if ((unsigned int)x >= DISP_W || (unsigned int)y >= DISP_H) {
 		return;
 	}
-	unsigned int pos = 8 + x * 8 + y % 8 + (y / 8) * 1024;
-	unsigned int bytepos = pos / 8;
-	unsigned int bitpos = pos % 8;
-	arr[bytepos] |= (1 << bitpos);
+	mark_dirty(fb, y >> 3, x, x);
+	apply_u8(fb->pix + (y >> 3) * DISP_W + x, 1 << (y & 7), color);
 }
 
-static void draw_line(uint8_t *arr, int x0, int y0, int x1, int y1) {
+static void draw_line(fb_t *fb, int x0, int y0, int x1, int y1, Color color) {
+	// Straight lines are spans
+	if (x0 == x1 || y0 == y1) {
+		fill_rect(fb, x0, y0, x1, y1, color);
+		return;
+	}
+
 	int dx = abs(x1 - x0);
 	int sx = x0 < x1 ? 1 : -1;
 	int dy = -abs(y1 - y0);
@@ -47,7 +306,7 @@ static void draw_line(uint8_t *arr, int x0, int y0, int x1, int y1) {
 	int error = dx + dy;
 	
 	while (true) {
-		set_pix(arr, x0, y0);
+		set_pix(fb, x0, y0, color);
 		if (x0 == x1 && y0 == y1) {
 			break;
 		}
@@ -68,6 +327,196 @@ static void draw_line(uint8_t *arr, int x0, int y0, int x1, int y1) {
 	}
 }
 
+static void draw_rect(fb_t *fb, int x, int y, int w, int h, Color color, bool fill) {
+	if (w <= 0 || h <= 0) {
+		return;
+	}
+
+	int x1 = x + w - 1;
+	int y1 = y + h - 1;
+
+	if (fill || w <= 2 || h <= 2) {
+		fill_rect(fb, x, y, x1, y1, color);
+		return;
+	}
+
+	// The sides do not overlap, so that inverting works
+	fill_rect(fb, x, y, x1, y, color);
+	fill_rect(fb, x, y1, x1, y1, color);
+	fill_rect(fb, x, y + 1, x, y1 - 1, color);
+	fill_rect(fb, x1, y + 1, x1, y1 - 1, color);
+}
+
+// The filled circle is drawn as one vertical span per column, which only takes
+// a few page operations per column.
+static void draw_circle(fb_t *fb, int cx, int cy, int r, Color color, bool fill) {
+	if (r < 0) {
+		return;
+	}
+
+	if (fill) {
+		int dy = r;
+		for (int dx = 0;dx <= r;dx++) {
+			while (dy > 0 && (dx * dx + dy * dy) > (r * r + r)) {
+				dy--;
+			}
+			fill_rect(fb, cx + dx, cy - dy, cx + dx, cy + dy, color);
+			if (dx != 0) {
+				fill_rect(fb, cx - dx, cy - dy, cx - dx, cy + dy, color);
+			}
+		}
+		return;
+	}
+
+	int x = r;
+	int y = 0;
+	int error = 1 - r;
+
+	while (x >= y) {
+		set_pix(fb, cx + x, cy + y, color);
+		set_pix(fb, cx - x, cy + y, color);
+		set_pix(fb, cx + x, cy - y, color);
+		set_pix(fb, cx - x, cy - y, color);
+		set_pix(fb, cx + y, cy + x, color);
+		set_pix(fb, cx - y, cy + x, color);
+		set_pix(fb, cx + y, cy - x, color);
+		set_pix(fb, cx - y, cy - x, color);
+
+		y++;
+		if (error < 0) {
+			error += 2 * y + 1;
+		} else {
+			x--;
+			error += 2 * (y - x) + 1;
+		}
+	}
+}
+
+// Draws the pixels that are set in sprite, which is in the same format as the
+// framebuffer with w columns and (h + 7) / 8 pages. Each sprite byte is shifted
+// into at most two pages of the framebuffer, and everything outside of the
+// display is clipped.
+static void blit(fb_t *fb, int x, int y, int w, int h, const uint8_t *sprite, Color color) {
+	int pages = (h + 7) / 8;
+
+	int i0 = x < 0 ? -x : 0;
+	int i1 = (x + w) > DISP_W ? DISP_W - x : w;
+	if (i0 >= i1) {
+		return;
+	}
+
+	for (int sp = 0;sp < pages;sp++) {
+		int yy = y + sp * 8;
+		if (yy <= -8 || yy >= DISP_H) {
+			continue;
+		}
+
+		int dp = yy >> 3;
+		int shift = yy & 7;
+		uint8_t last_mask = (sp == pages - 1 && (h & 7)) ? (0xFF >> (8 - (h & 7))) : 0xFF;
+		const uint8_t *src = sprite + sp * w;
+
+		if (dp >= 0) {
+			mark_dirty(fb, dp, x + i0, x + i1 - 1);
+		}
+		if (shift && (dp + 1) < DISP_PAGES) {
+			mark_dirty(fb, dp + 1, x + i0, x + i1 - 1);
+		}
+
+		for (int i = i0;i < i1;i++) {
+			uint8_t b = src[i] & last_mask;
+			if (!b) {
+				continue;
+			}
+
+			uint8_t *p = fb->pix + x + i;
+			if (dp >= 0) {
+				apply_u8(p + dp * DISP_W, b << shift, color);
+			}
+			if (shift && (dp + 1) < DISP_PAGES) {
+				apply_u8(p + (dp + 1) * DISP_W, b >> (8 - shift), color);
+			}
+		}
+	}
+}
+
+// Returns the x-position after the text. Characters that are not in the font are
+// drawn as '?'.
+static int draw_text(fb_t *fb, int x, int y, const char *str, Color color, int scale) {
+	int x_start = x;
+
+	for (;*str;str++) {
+		char c = *str;
+
+		if (c == '\n') {
+			x = x_start;
+			y += 8 * scale;
+			continue;
+		}
+
+		if (c < FONT_FIRST || c > FONT_LAST) {
+			c = '?';
+		}
+
+		const uint8_t *glyph = font5x7 + (c - FONT_FIRST) * FONT_W;
+
+		if (scale == 1) {
+			blit(fb, x, y, FONT_W, 7, glyph, color);
+		} else {
+			for (int i = 0;i < FONT_W;i++) {
+				for (int j = 0;j < 7;j++) {
+					if (glyph[i] & (1 << j)) {
+						int px = x + i * scale;
+						int py = y + j * scale;
+						fill_rect(fb, px, py, px + scale - 1, py + scale - 1, color);
+					}
+				}
+			}
+		}
+
+		x += (FONT_W + 1) * scale;
+	}
+
+	return x;
+}
+
+static bool get_ints(lbm_value *args, lbm_uint argn, int *res, int num) {
+	if (argn < (lbm_uint)num) {
+		return false;
+	}
+
+	for (int i = 0;i < num;i++) {
+		if (!VESC_IF->lbm_is_number(args[i])) {
+			return false;
+		}
+		res[i] = VESC_IF->lbm_dec_as_i32(args[i]);
+	}
+
+	return true;
+}
+
+// Optional color argument, white by default
+static bool get_color(lbm_value *args, lbm_uint argn, lbm_uint ind, Color *color) {
+	*color = COLOR_WHITE;
+	if (argn > ind) {
+		if (!VESC_IF->lbm_is_number(args[ind])) {
+			return false;
+		}
+		int c = VESC_IF->lbm_dec_as_i32(args[ind]);
+		if (c < COLOR_BLACK || c > COLOR_INVERT) {
+			return false;
+		}
+		*color = (Color)c;
+	}
+	return true;
+}
+
+static bool get_flag(lbm_value *args, lbm_uint argn, lbm_uint ind) {
+	return argn > ind && !VESC_IF->lbm_is_symbol_nil(args[ind]);
+}
+
+// (ext-drawline buf x0 y0 x1 y1), draws into buf, which is a byte array with the
+// data control byte followed by the framebuffer
 static lbm_value ssd_drawline(lbm_value *args, lbm_uint argn) {
 	lbm_value res = VESC_IF->lbm_enc_sym_eerror;
 
@@ -77,22 +526,421 @@ static lbm_value ssd_drawline(lbm_value *args, lbm_uint argn) {
 		return res;
 	}
 	
-	uint8_t *pixbuf = (uint8_t*)(((lbm_array_header_t *)VESC_IF->lbm_car(args[0]))->data);
+	lbm_array_header_t *array = (lbm_array_header_t*)VESC_IF->lbm_car(args[0]);
+	if (array->size < (FB_SIZE + 1)) {
+		return res;
+	}
+
+	// Dirty tracking is not used here, as the buffer is sent by the script
+	fb_t fb;
+	fb.pix = (uint8_t*)array->data + 1;
+	mark_clean(&fb);
 	int x0 = VESC_IF->lbm_dec_as_i32(args[1]);
 	int y0 = VESC_IF->lbm_dec_as_i32(args[2]);
 	int x1 = VESC_IF->lbm_dec_as_i32(args[3]);
 	int y1 = VESC_IF->lbm_dec_as_i32(args[4]);
 	
-	draw_line(pixbuf, x0, y0, x1, y1);
+	draw_line(&fb, x0, y0, x1, y1, COLOR_WHITE);
 	
 	return VESC_IF->lbm_enc_sym_true;
 }
 
+// (ext-ssd-clear optColor)
+static lbm_value ext_clear(lbm_value *args, lbm_uint argn) {
+	Color color;
+	if (argn > 1 || !get_color(args, argn, 0, &color)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	// Black by default here
+	if (argn == 0) {
+		color = COLOR_BLACK;
+	}
+
+	data *d = (data*)ARG;
+	if (color == COLOR_INVERT) {
+		fill_rect(&d->fb, 0, 0, DISP_W - 1, DISP_H - 1, color);
+	} else {
+		memset(d->fb.pix, color == COLOR_WHITE ? 0xFF : 0x00, FB_SIZE);
+		mark_all(&d->fb);
+	}
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ssd-pixel x y optColor)
+static lbm_value ext_pixel(lbm_value *args, lbm_uint argn) {
+	int a[2];
+	Color color;
+	if (argn > 3 || !get_ints(args, argn, a, 2) || !get_color(args, argn, 2, &color)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	set_pix(&((data*)ARG)->fb, a[0], a[1], color);
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ssd-line x0 y0 x1 y1 optColor)
+static lbm_value ext_line(lbm_value *args, lbm_uint argn) {
+	int a[4];
+	Color color;
+	if (argn > 5 || !get_ints(args, argn, a, 4) || !get_color(args, argn, 4, &color)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	draw_line(&((data*)ARG)->fb, a[0], a[1], a[2], a[3], color);
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ssd-hline x y w optColor)
+static lbm_value ext_hline(lbm_value *args, lbm_uint argn) {
+	int a[3];
+	Color color;
+	if (argn > 4 || !get_ints(args, argn, a, 3) || !get_color(args, argn, 3, &color)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	draw_rect(&((data*)ARG)->fb, a[0], a[1], a[2], 1, color, true);
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ssd-vline x y h optColor)
+static lbm_value ext_vline(lbm_value *args, lbm_uint argn) {
+	int a[3];
+	Color color;
+	if (argn > 4 || !get_ints(args, argn, a, 3) || !get_color(args, argn, 3, &color)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	draw_rect(&((data*)ARG)->fb, a[0], a[1], 1, a[2], color, true);
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ssd-rect x y w h optColor optFill)
+static lbm_value ext_rect(lbm_value *args, lbm_uint argn) {
+	int a[4];
+	Color color;
+	if (argn > 6 || !get_ints(args, argn, a, 4) || !get_color(args, argn, 4, &color)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	draw_rect(&((data*)ARG)->fb, a[0], a[1], a[2], a[3], color, get_flag(args, argn, 5));
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ssd-circle cx cy r optColor optFill)
+static lbm_value ext_circle(lbm_value *args, lbm_uint argn) {
+	int a[3];
+	Color color;
+	if (argn > 5 || !get_ints(args, argn, a, 3) || !get_color(args, argn, 3, &color)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	draw_circle(&((data*)ARG)->fb, a[0], a[1], a[2], color, get_flag(args, argn, 4));
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ssd-blit x y w h sprite optColor), sprite is a byte array with one byte
+// per column and page, like the framebuffer
+static lbm_value ext_blit(lbm_value *args, lbm_uint argn) {
+	int a[4];
+	Color color;
+	if (argn < 5 || argn > 6 || !get_ints(args, argn, a, 4) ||
+			!VESC_IF->lbm_is_byte_array(args[4]) || !get_color(args, argn, 5, &color)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	if (a[2] <= 0 || a[3] <= 0) {
+		return VESC_IF->lbm_enc_sym_true;
+	}
+
+	// The size is computed in 64 bits, as it overflows an int for large w and h
+	lbm_array_header_t *array = (lbm_array_header_t*)VESC_IF->lbm_car(args[4]);
+	if ((uint64_t)array->size < (uint64_t)a[2] * (((uint64_t)a[3] + 7) / 8)) {
+		VESC_IF->lbm_set_error_reason("Sprite too small");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	// Sprites that are entirely off-screen are skipped, which also keeps x + w
+	// and y + h in blit from overflowing
+	if (a[0] >= DISP_W || a[1] >= DISP_H || a[0] <= -a[2] || a[1] <= -a[3]) {
+		return VESC_IF->lbm_enc_sym_true;
+	}
+
+	blit(&((data*)ARG)->fb, a[0], a[1], a[2], a[3], (uint8_t*)array->data, color);
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ssd-text x y str optColor optScale), returns the x-position after the
+// text so that more text can be appended
+static lbm_value ext_text(lbm_value *args, lbm_uint argn) {
+	int a[2];
+	Color color;
+	if (argn < 3 || argn > 5 || !get_ints(args, argn, a, 2) || !get_color(args, argn, 3, &color)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	char *str = VESC_IF->lbm_dec_str(args[2]);
+	if (!str) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	int scale = 1;
+	if (argn >= 5) {
+		if (!VESC_IF->lbm_is_number(args[4])) {
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+		scale = VESC_IF->lbm_dec_as_i32(args[4]);
+		if (scale < 1 || scale > 8) {
+			VESC_IF->lbm_set_error_reason("Invalid Scale");
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+	}
+
+	return VESC_IF->lbm_enc_i(draw_text(&((data*)ARG)->fb, a[0], a[1], str, color, scale));
+}
+
+// (ext-ssd-copy buf), copies the data control byte and the framebuffer to buf,
+// which must be at least 1025 bytes. It can then be sent with i2c-tx-rx.
+static lbm_value ext_copy(lbm_value *args, lbm_uint argn) {
+	if (argn != 1 || !VESC_IF->lbm_is_byte_array(args[0])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	lbm_array_header_t *array = (lbm_array_header_t*)VESC_IF->lbm_car(args[0]);
+	if (array->size < (FB_SIZE + 1)) {
+		VESC_IF->lbm_set_error_reason("Buffer too small");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	memcpy(array->data, d->fb.pix - 1, FB_SIZE + 1);
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+static bool send_cmds(data *d, const uint8_t *cmds, int len) {
+	uint8_t buf[8];
+	buf[0] = CTRL_CMD;
+	memcpy(buf + 1, cmds, len);
+	return i2c_bb_tx_rx(&d->i2c, d->i2c_addr, buf, len + 1, 0, 0);
+}
+
+// Sends the columns x0 to x1 on the pages p0 to p1. The address window is set
+// once, and then the part of every page is sent with the data control byte
+// temporarily written before it, so that nothing has to be copied.
+static bool send_window(data *d, int p0, int p1, int x0, int x1) {
+	uint8_t cmds[] = {0x21, x0, x1, 0x22, p0, p1};
+	if (!send_cmds(d, cmds, sizeof(cmds))) {
+		return false;
+	}
+
+	for (int p = p0;p <= p1;p++) {
+		uint8_t *start = d->fb.pix + p * DISP_W + x0 - 1;
+		uint8_t saved = *start;
+		*start = CTRL_DATA;
+		bool ok = i2c_bb_tx_rx(&d->i2c, d->i2c_addr, start, x1 - x0 + 2, 0, 0);
+		*start = saved;
+
+		if (!ok) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Sends the changed parts of the framebuffer, returns the number of pixel bytes
+// that were sent or -1 on I2C errors
+static int flush(data *d) {
+	fb_t *fb = &d->fb;
+	int sent = 0;
+	int p = 0;
+
+	while (p < DISP_PAGES) {
+		if (fb->dirty_x0[p] > fb->dirty_x1[p]) {
+			p++;
+			continue;
+		}
+
+		int p0 = p;
+		int x0 = fb->dirty_x0[p];
+		int x1 = fb->dirty_x1[p];
+		int bytes = x1 - x0 + 1;
+
+		// Merge the following dirty pages while that does not waste much
+		while ((p + 1) < DISP_PAGES && fb->dirty_x0[p + 1] <= fb->dirty_x1[p + 1]) {
+			int nx0 = fb->dirty_x0[p + 1] < x0 ? fb->dirty_x0[p + 1] : x0;
+			int nx1 = fb->dirty_x1[p + 1] > x1 ? fb->dirty_x1[p + 1] : x1;
+			int nbytes = (nx1 - nx0 + 1) * (p + 2 - p0);
+			int sep = bytes + fb->dirty_x1[p + 1] - fb->dirty_x0[p + 1] + 1;
+
+			if (nbytes - sep > MERGE_MAX_EXTRA) {
+				break;
+			}
+
+			x0 = nx0;
+			x1 = nx1;
+			bytes = nbytes;
+			p++;
+		}
+
+		if (!send_window(d, p0, p, x0, x1)) {
+			return -1;
+		}
+
+		for (int i = p0;i <= p;i++) {
+			fb->dirty_x0[i] = 0xFF;
+			fb->dirty_x1[i] = 0;
+		}
+
+		sent += bytes;
+		p++;
+	}
+
+	return sent;
+}
+
+static bool get_pin(lbm_value *args, lbm_uint argn, unsigned int ind,
+		char *def, void **gpio, uint32_t *pin) {
+	lbm_uint sym;
+	if (argn > ind) {
+		if (!VESC_IF->lbm_is_symbol(args[ind])) {
+			return false;
+		}
+		sym = VESC_IF->lbm_dec_sym(args[ind]);
+	} else if (!VESC_IF->lbm_get_symbol_by_name(def, &sym)) {
+		return false;
+	}
+
+	return VESC_IF->lbm_symbol_to_io(sym, gpio, pin);
+}
+
+// (ext-ssd-init optPinSda optPinScl optAddr), sets up I2C on the pins and
+// configures the display for 128x64 with horizontal addressing. The whole
+// framebuffer is sent on the next flush. Returns nil if the display does not
+// respond.
+static lbm_value ext_init(lbm_value *args, lbm_uint argn) {
+	if (argn > 3 || (argn == 3 && !VESC_IF->lbm_is_number(args[2]))) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	void *sda_gpio, *scl_gpio;
+	uint32_t sda_pin, scl_pin;
+	if (!get_pin(args, argn, 0, "pin-rx", &sda_gpio, &sda_pin) ||
+			!get_pin(args, argn, 1, "pin-tx", &scl_gpio, &scl_pin)) {
+		VESC_IF->lbm_set_error_reason("Invalid Pin");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	d->i2c_addr = argn == 3 ? VESC_IF->lbm_dec_as_i32(args[2]) : I2C_ADDR_DEFAULT;
+	i2c_bb_init(&d->i2c, sda_gpio, sda_pin, scl_gpio, scl_pin, I2C_RATE);
+
+	static const uint8_t init_cmds[][3] = {
+			{0xAE}, // Display off
+			{0xD5, 0x80}, // Clock divider
+			{0xA8, DISP_H - 1}, // Multiplex ratio
+			{0xD3, 0x00}, // No display offset
+			{0x40}, // Start line 0
+			{0x8D, 0x14}, // Charge pump on
+			{0x20, 0x00}, // Horizontal addressing
+			{0xA1}, // Segment remap
+			{0xC8}, // COM scan direction
+			{0xDA, 0x12}, // COM pins
+			{0x81, 0xCF}, // Contrast
+			{0xD9, 0xF1}, // Precharge
+			{0xDB, 0x40}, // VCOMH
+			{0xA4}, // Display RAM
+			{0xA6}, // Not inverted
+			{0xAF}, // Display on
+	};
+	static const uint8_t init_lens[] = {1, 2, 2, 2, 1, 2, 2, 1, 1, 2, 2, 2, 2, 1, 1, 1};
+
+	d->i2c_ok = true;
+	for (unsigned int i = 0;i < sizeof(init_lens);i++) {
+		if (!send_cmds(d, init_cmds[i], init_lens[i])) {
+			d->i2c_ok = false;
+			break;
+		}
+	}
+
+	mark_all(&d->fb);
+	return d->i2c_ok ? VESC_IF->lbm_enc_sym_true : VESC_IF->lbm_enc_sym_nil;
+}
+
+// (ext-ssd-flush optFull), sends the parts of the framebuffer that have changed
+// since the last flush, or everything if optFull is true. Returns the number of
+// pixel bytes that were sent, or nil if the display does not respond.
+static lbm_value ext_flush(lbm_value *args, lbm_uint argn) {
+	if (argn > 1) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	if (!d->i2c_ok) {
+		VESC_IF->lbm_set_error_reason("Run ext-ssd-init first");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	if (get_flag(args, argn, 0)) {
+		mark_all(&d->fb);
+	}
+
+	int sent = flush(d);
+	if (sent < 0) {
+		// Send everything next time, as the display state is unknown
+		mark_all(&d->fb);
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	return VESC_IF->lbm_enc_i(sent);
+}
+
+static void stop(void *arg) {
+	data *d = (data*)arg;
+	VESC_IF->free(d->mem);
+	VESC_IF->free(d);
+}
+
 INIT_FUN(lib_info *info) {
 	INIT_START
 
-	(void)info;
+	data *d = VESC_IF->malloc(sizeof(data));
+	if (!d) {
+		return false;
+	}
+
+	// One word before the pixels, where the last byte is the control byte
+	d->mem = VESC_IF->malloc(FB_SIZE + 8);
+	if (!d->mem) {
+		VESC_IF->free(d);
+		return false;
+	}
+
+	d->fb.pix = (uint8_t*)(((uintptr_t)d->mem + 4 + 3) & ~3);
+	d->fb.pix[-1] = CTRL_DATA;
+	memset(d->fb.pix, 0, FB_SIZE);
+	mark_all(&d->fb);
+
+	d->i2c_ok = false;
+	d->i2c_addr = I2C_ADDR_DEFAULT;
+
 	VESC_IF->lbm_add_extension("ext-drawline", ssd_drawline);
+	VESC_IF->lbm_add_extension("ext-ssd-clear", ext_clear);
+	VESC_IF->lbm_add_extension("ext-ssd-pixel", ext_pixel);
+	VESC_IF->lbm_add_extension("ext-ssd-line", ext_line);
+	VESC_IF->lbm_add_extension("ext-ssd-hline", ext_hline);
+	VESC_IF->lbm_add_extension("ext-ssd-vline", ext_vline);
+	VESC_IF->lbm_add_extension("ext-ssd-rect", ext_rect);
+	VESC_IF->lbm_add_extension("ext-ssd-circle", ext_circle);
+	VESC_IF->lbm_add_extension("ext-ssd-blit", ext_blit);
+	VESC_IF->lbm_add_extension("ext-ssd-text", ext_text);
+	VESC_IF->lbm_add_extension("ext-ssd-copy", ext_copy);
+	VESC_IF->lbm_add_extension("ext-ssd-init", ext_init);
+	VESC_IF->lbm_add_extension("ext-ssd-flush", ext_flush);
+
+	info->stop_fun = stop;
+	info->arg = d;
+
 	return true;
 }
-
@@ -0,0 +1,608 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#define _GNU_SOURCE
+
+#include "vesc_host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#define MAX_EXTENSIONS		256
+#define MAX_SYMBOLS			256
+#define SYM_FIRST_USER		0x100
+#define NUM_SLOTS			4096
+#define CONS_SLOTS			16384
+#define ARRAY_SLOTS			4096
+#define EEPROM_VARS			512
+
+// Value tags in the two lowest bits
+#define TAG_SYM				0
+#define TAG_NUM				1
+#define TAG_ARRAY			2
+#define TAG_CONS			3
+#define TAG(v)				((v) & 3)
+#define IND(v)				((v) >> 2)
+#define ENC(ind, tag)		(((lbm_value)(ind) << 2) | (tag))
+
+#define SYM_NIL				0
+#define SYM_TRUE			1
+#define SYM_TERROR			2
+#define SYM_EERROR			3
+#define SYM_MERROR			4
+
+typedef enum {
+	NUM_I = 0,
+	NUM_U,
+	NUM_F,
+	NUM_CHAR
+} num_type;
+
+typedef struct {
+	num_type type;
+	union {
+		int32_t i;
+		uint32_t u;
+		float f;
+	};
+} num_slot;
+
+typedef struct {
+	lbm_value car;
+	lbm_value cdr;
+} cons_slot;
+
+typedef struct {
+	void (*fun)(void *arg);
+	void *arg;
+	pthread_t thread;
+	volatile bool terminate;
+} host_thread;
+
+static vesc_c_if host_if;
+vesc_c_if *vesc_host_if = &host_if;
+
+static lib_info info;
+static bool loaded = false;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static num_slot nums[NUM_SLOTS];
+static uint32_t num_next = 0;
+static cons_slot conses[CONS_SLOTS];
+static uint32_t cons_next = 0;
+static lbm_array_header_t *arrays = 0; // In the lower 4 GB
+static void *array_data[ARRAY_SLOTS]; // Same pointers, visible to LeakSanitizer
+static uint32_t array_next = 0;
+
+static struct {
+	char name[64];
+	extension_fptr fun;
+} extensions[MAX_EXTENSIONS];
+static int extension_num = 0;
+
+static char *symbols[MAX_SYMBOLS];
+static int symbol_num = 0;
+
+static const char *error_reason = 0;
+
+static pthread_mutex_t block_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t block_cond = PTHREAD_COND_INITIALIZER;
+static bool blocked = false;
+static bool unblocked = false;
+static lbm_value unblock_value = 0;
+
+static pthread_mutex_t sys_mutex;
+static __thread host_thread *current_thread = 0;
+static struct timespec start_time;
+static eeprom_var eeprom[EEPROM_VARS];
+
+// Used for everything that is not mocked. Returns 0 in both the integer and
+// the floating point return register, so it works for all signatures in the
+// table.
+void vesc_host_zero(void) __attribute__((visibility("hidden")));
+#if defined(__x86_64__)
+__asm__(".text\n.globl vesc_host_zero\n.hidden vesc_host_zero\nvesc_host_zero:\n"
+		"xor %eax, %eax\nxor %edx, %edx\npxor %xmm0, %xmm0\npxor %xmm1, %xmm1\nret\n");
+#elif defined(__aarch64__)
+__asm__(".text\n.globl vesc_host_zero\n.hidden vesc_host_zero\nvesc_host_zero:\n"
+		"mov x0, #0\nmov x1, #0\nmovi d0, #0\nmovi d1, #0\nret\n");
+#else
+#error "Unsupported host architecture"
+#endif
+
+// Time
+static double now_s(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)(ts.tv_sec - start_time.tv_sec) + (double)(ts.tv_nsec - start_time.tv_nsec) * D(1e-9);
+}
+
+static void sleep_s(double s) {
+	if (s <= D(0.0)) {
+		return;
+	}
+	struct timespec ts;
+	ts.tv_sec = (time_t)s;
+	ts.tv_nsec = (long)((s - (double)ts.tv_sec) * D(1e9));
+	nanosleep(&ts, 0);
+}
+
+static void host_sleep_ms(uint32_t ms) { sleep_s(ms * D(1e-3)); }
+static void host_sleep_us(uint32_t us) { sleep_s(us * D(1e-6)); }
+static void host_timer_sleep(float seconds) { sleep_s((double)seconds); }
+static float host_system_time(void) { return now_s(); }
+
+// The timer counts in microseconds and systime in 1/10000 s, like the firmware
+static uint32_t host_timer_time_now(void) {
+	return (uint32_t)(uint64_t)(now_s() * D(1e6));
+}
+
+static float host_timer_seconds_elapsed_since(uint32_t time) {
+	return (float)(uint32_t)(host_timer_time_now() - time) * 1e-6;
+}
+
+static float host_ts_to_age_s(systime_t ts) {
+	return (float)(uint32_t)((uint32_t)(uint64_t)(now_s() * D(1e4)) - ts) * 1e-4;
+}
+
+static int host_printf(const char *str, ...) {
+	va_list args;
+	va_start(args, str);
+	int res = vprintf(str, args);
+	va_end(args);
+	printf("\n");
+	return res;
+}
+
+static void *host_malloc(size_t bytes) { return malloc(bytes); }
+static void host_free(void *ptr) { free(ptr); }
+
+// Threads
+static void *thread_fun(void *arg) {
+	host_thread *t = (host_thread*)arg;
+	current_thread = t;
+	t->fun(t->arg);
+	return 0;
+}
+
+static lib_thread host_spawn(void (*fun)(void *arg), size_t stack_size, char *name, void *arg) {
+	(void)stack_size; (void)name;
+
+	host_thread *t = calloc(1, sizeof(host_thread));
+	if (!t) {
+		return 0;
+	}
+
+	t->fun = fun;
+	t->arg = arg;
+
+	if (pthread_create(&t->thread, 0, thread_fun, t) != 0) {
+		free(t);
+		return 0;
+	}
+
+	return t;
+}
+
+static void host_request_terminate(lib_thread thd) {
+	host_thread *t = (host_thread*)thd;
+	if (!t) {
+		return;
+	}
+	t->terminate = true;
+	pthread_join(t->thread, 0);
+	free(t);
+}
+
+static bool host_should_terminate(void) {
+	return current_thread && current_thread->terminate;
+}
+
+static void **host_get_arg(uint32_t prog_addr) {
+	(void)prog_addr;
+	return &info.arg;
+}
+
+static lib_mutex host_mutex_create(void) {
+	pthread_mutex_t *m = malloc(sizeof(pthread_mutex_t));
+	if (m) {
+		pthread_mutex_init(m, 0);
+	}
+	return m;
+}
+
+static void host_mutex_lock(lib_mutex m) { pthread_mutex_lock((pthread_mutex_t*)m); }
+static void host_mutex_unlock(lib_mutex m) { pthread_mutex_unlock((pthread_mutex_t*)m); }
+static void host_sys_lock(void) { pthread_mutex_lock(&sys_mutex); }
+static void host_sys_unlock(void) { pthread_mutex_unlock(&sys_mutex); }
+
+static bool host_read_eeprom_var(eeprom_var *v, int address) {
+	if (address < 0 || address >= EEPROM_VARS) {
+		return false;
+	}
+	*v = eeprom[address];
+	return true;
+}
+
+static bool host_store_eeprom_var(eeprom_var *v, int address) {
+	if (address < 0 || address >= EEPROM_VARS) {
+		return false;
+	}
+	eeprom[address] = *v;
+	return true;
+}
+
+static void host_imu_get_quaternions(float *q) {
+	q[0] = 1.0;
+	q[1] = 0.0;
+	q[2] = 0.0;
+	q[3] = 0.0;
+}
+
+// LispBM
+static bool host_lbm_add_extension(char *name, extension_fptr fun) {
+	for (int i = 0;i < extension_num;i++) {
+		if (strcmp(extensions[i].name, name) == 0) {
+			extensions[i].fun = fun;
+			return true;
+		}
+	}
+
+	if (extension_num >= MAX_EXTENSIONS || strlen(name) >= sizeof(extensions[0].name)) {
+		return false;
+	}
+
+	strcpy(extensions[extension_num].name, name);
+	extensions[extension_num].fun = fun;
+	extension_num++;
+	return true;
+}
+
+static void host_lbm_block_ctx_from_extension(void) {
+	pthread_mutex_lock(&block_mutex);
+	blocked = true;
+	pthread_mutex_unlock(&block_mutex);
+}
+
+static bool host_lbm_unblock_ctx(lbm_cid cid, lbm_value val) {
+	(void)cid;
+	pthread_mutex_lock(&block_mutex);
+	unblocked = true;
+	unblock_value = val;
+	pthread_cond_broadcast(&block_cond);
+	pthread_mutex_unlock(&block_mutex);
+	return true;
+}
+
+static lbm_cid host_lbm_get_current_cid(void) { return 1; }
+
+static int host_lbm_set_error_reason(char *str) {
+	error_reason = str;
+	return 1;
+}
+
+static lbm_value enc_num(num_type type, uint32_t bits) {
+	pthread_mutex_lock(&pool_mutex);
+	uint32_t ind = num_next;
+	num_next = (num_next + 1) % NUM_SLOTS;
+	nums[ind].type = type;
+	nums[ind].u = bits;
+	pthread_mutex_unlock(&pool_mutex);
+	return ENC(ind, TAG_NUM);
+}
+
+static lbm_value host_lbm_enc_i(lbm_int x) { return enc_num(NUM_I, (uint32_t)x); }
+static lbm_value host_lbm_enc_u(lbm_uint x) { return enc_num(NUM_U, x); }
+static lbm_value host_lbm_enc_char(char x) { return enc_num(NUM_CHAR, (uint8_t)x); }
+static lbm_value host_lbm_enc_u32(uint32_t x) { return enc_num(NUM_U, x); }
+static lbm_value host_lbm_enc_i32(int32_t x) { return enc_num(NUM_I, (uint32_t)x); }
+
+static lbm_value host_lbm_enc_float(float f) {
+	uint32_t bits;
+	memcpy(&bits, &f, 4);
+	return enc_num(NUM_F, bits);
+}
+
+static lbm_value host_lbm_enc_sym(lbm_uint s) { return ENC(s, TAG_SYM); }
+
+static bool host_lbm_is_number(lbm_value x) {
+	return TAG(x) == TAG_NUM && nums[IND(x)].type != NUM_CHAR;
+}
+
+static bool host_lbm_is_char(lbm_value x) {
+	return TAG(x) == TAG_NUM && nums[IND(x)].type == NUM_CHAR;
+}
+
+static bool host_lbm_is_symbol(lbm_value x) { return TAG(x) == TAG_SYM; }
+static bool host_lbm_is_cons(lbm_value x) { return TAG(x) == TAG_CONS; }
+static bool host_lbm_is_byte_array(lbm_value x) { return TAG(x) == TAG_ARRAY; }
+static bool host_lbm_is_symbol_nil(lbm_uint x) { return x == ENC(SYM_NIL, TAG_SYM); }
+static bool host_lbm_is_symbol_true(lbm_uint x) { return x == ENC(SYM_TRUE, TAG_SYM); }
+
+static float host_lbm_dec_as_float(lbm_value x) {
+	if (TAG(x) != TAG_NUM) {
+		return 0.0;
+	}
+	num_slot *n = &nums[IND(x)];
+	switch (n->type) {
+	case NUM_I: return (float)n->i;
+	case NUM_F: return n->f;
+	default: return (float)n->u;
+	}
+}
+
+static uint32_t host_lbm_dec_as_u32(lbm_value x) {
+	if (TAG(x) != TAG_NUM) {
+		return 0;
+	}
+	num_slot *n = &nums[IND(x)];
+	return n->type == NUM_F ? (uint32_t)n->f : n->u;
+}
+
+static int32_t host_lbm_dec_as_i32(lbm_value x) {
+	if (TAG(x) != TAG_NUM) {
+		return 0;
+	}
+	num_slot *n = &nums[IND(x)];
+	return n->type == NUM_F ? (int32_t)n->f : n->i;
+}
+
+static char host_lbm_dec_char(lbm_value x) { return (char)host_lbm_dec_as_u32(x); }
+static lbm_uint host_lbm_dec_sym(lbm_value x) { return IND(x); }
+
+static lbm_value host_lbm_cons(lbm_value car, lbm_value cdr) {
+	pthread_mutex_lock(&pool_mutex);
+	uint32_t ind = cons_next;
+	cons_next = (cons_next + 1) % CONS_SLOTS;
+	conses[ind].car = car;
+	conses[ind].cdr = cdr;
+	pthread_mutex_unlock(&pool_mutex);
+	return ENC(ind, TAG_CONS);
+}
+
+// Like in LispBM, car of an array is its header
+static lbm_value host_lbm_car(lbm_value x) {
+	switch (TAG(x)) {
+	case TAG_CONS: return conses[IND(x)].car;
+	case TAG_ARRAY: return (lbm_value)(uintptr_t)&arrays[IND(x)];
+	default: return ENC(SYM_NIL, TAG_SYM);
+	}
+}
+
+static lbm_value host_lbm_cdr(lbm_value x) {
+	return TAG(x) == TAG_CONS ? conses[IND(x)].cdr : ENC(SYM_NIL, TAG_SYM);
+}
+
+static lbm_value host_lbm_list_destructive_reverse(lbm_value list) {
+	lbm_value prev = ENC(SYM_NIL, TAG_SYM);
+	while (TAG(list) == TAG_CONS) {
+		lbm_value next = conses[IND(list)].cdr;
+		conses[IND(list)].cdr = prev;
+		prev = list;
+		list = next;
+	}
+	return prev;
+}
+
+static bool host_lbm_create_byte_array(lbm_value *value, lbm_uint num_elt) {
+	// One extra byte so that strings are always terminated
+	uint8_t *data = calloc(num_elt + 1, 1);
+	if (!data) {
+		return false;
+	}
+
+	pthread_mutex_lock(&pool_mutex);
+	uint32_t ind = array_next;
+	array_next = (array_next + 1) % ARRAY_SLOTS;
+	free(array_data[ind]);
+	array_data[ind] = data;
+	arrays[ind].elt_type = 0;
+	arrays[ind].size = num_elt;
+	arrays[ind].data = (lbm_uint*)data;
+	pthread_mutex_unlock(&pool_mutex);
+
+	*value = ENC(ind, TAG_ARRAY);
+	return true;
+}
+
+static char *host_lbm_dec_str(lbm_value x) {
+	return TAG(x) == TAG_ARRAY ? (char*)arrays[IND(x)].data : 0;
+}
+
+static int host_lbm_get_symbol_by_name(char *name, lbm_uint *id) {
+	for (int i = 0;i < symbol_num;i++) {
+		if (strcmp(symbols[i], name) == 0) {
+			*id = SYM_FIRST_USER + i;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int host_lbm_add_symbol_const(char *name, lbm_uint *id) {
+	if (host_lbm_get_symbol_by_name(name, id)) {
+		return 1;
+	}
+	if (symbol_num >= MAX_SYMBOLS) {
+		return 0;
+	}
+	symbols[symbol_num] = strdup(name);
+	*id = SYM_FIRST_USER + symbol_num;
+	symbol_num++;
+	return 1;
+}
+
+void vesc_host_init(void) {
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&sys_mutex, &attr);
+
+	if (!arrays) {
+		arrays = mmap(0, ARRAY_SLOTS * sizeof(lbm_array_header_t), PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+		if (arrays == MAP_FAILED) {
+			fprintf(stderr, "vesc_host: could not map array headers\n");
+			abort();
+		}
+	}
+
+	// Everything returns zero unless it is mocked below. The symbol constants are
+	// overwritten afterwards.
+	void **slots = (void**)&host_if;
+	for (size_t i = 0;i < sizeof(host_if) / sizeof(void*);i++) {
+		slots[i] = (void*)vesc_host_zero;
+	}
+
+	host_if.lbm_enc_sym_nil = ENC(SYM_NIL, TAG_SYM);
+	host_if.lbm_enc_sym_true = ENC(SYM_TRUE, TAG_SYM);
+	host_if.lbm_enc_sym_terror = ENC(SYM_TERROR, TAG_SYM);
+	host_if.lbm_enc_sym_eerror = ENC(SYM_EERROR, TAG_SYM);
+	host_if.lbm_enc_sym_merror = ENC(SYM_MERROR, TAG_SYM);
+
+	host_if.lbm_add_extension = host_lbm_add_extension;
+	host_if.lbm_block_ctx_from_extension = host_lbm_block_ctx_from_extension;
+	host_if.lbm_unblock_ctx = host_lbm_unblock_ctx;
+	host_if.lbm_get_current_cid = host_lbm_get_current_cid;
+	host_if.lbm_set_error_reason = host_lbm_set_error_reason;
+	host_if.lbm_cons = host_lbm_cons;
+	host_if.lbm_car = host_lbm_car;
+	host_if.lbm_cdr = host_lbm_cdr;
+	host_if.lbm_list_destructive_reverse = host_lbm_list_destructive_reverse;
+	host_if.lbm_create_byte_array = host_lbm_create_byte_array;
+	host_if.lbm_add_symbol_const = host_lbm_add_symbol_const;
+	host_if.lbm_get_symbol_by_name = host_lbm_get_symbol_by_name;
+	host_if.lbm_enc_i = host_lbm_enc_i;
+	host_if.lbm_enc_u = host_lbm_enc_u;
+	host_if.lbm_enc_char = host_lbm_enc_char;
+	host_if.lbm_enc_float = host_lbm_enc_float;
+	host_if.lbm_enc_u32 = host_lbm_enc_u32;
+	host_if.lbm_enc_i32 = host_lbm_enc_i32;
+	host_if.lbm_enc_sym = host_lbm_enc_sym;
+	host_if.lbm_dec_as_float = host_lbm_dec_as_float;
+	host_if.lbm_dec_as_u32 = host_lbm_dec_as_u32;
+	host_if.lbm_dec_as_i32 = host_lbm_dec_as_i32;
+	host_if.lbm_dec_char = host_lbm_dec_char;
+	host_if.lbm_dec_str = host_lbm_dec_str;
+	host_if.lbm_dec_sym = host_lbm_dec_sym;
+	host_if.lbm_is_byte_array = host_lbm_is_byte_array;
+	host_if.lbm_is_cons = host_lbm_is_cons;
+	host_if.lbm_is_number = host_lbm_is_number;
+	host_if.lbm_is_char = host_lbm_is_char;
+	host_if.lbm_is_symbol = host_lbm_is_symbol;
+	host_if.lbm_is_symbol_nil = host_lbm_is_symbol_nil;
+	host_if.lbm_is_symbol_true = host_lbm_is_symbol_true;
+
+	host_if.sleep_ms = host_sleep_ms;
+	host_if.sleep_us = host_sleep_us;
+	host_if.system_time = host_system_time;
+	host_if.ts_to_age_s = host_ts_to_age_s;
+	host_if.printf = host_printf;
+	host_if.malloc = host_malloc;
+	host_if.free = host_free;
+	host_if.spawn = host_spawn;
+	host_if.request_terminate = host_request_terminate;
+	host_if.should_terminate = host_should_terminate;
+	host_if.get_arg = host_get_arg;
+	host_if.mutex_create = host_mutex_create;
+	host_if.mutex_lock = host_mutex_lock;
+	host_if.mutex_unlock = host_mutex_unlock;
+	host_if.sys_lock = host_sys_lock;
+	host_if.sys_unlock = host_sys_unlock;
+	host_if.timer_time_now = host_timer_time_now;
+	host_if.timer_seconds_elapsed_since = host_timer_seconds_elapsed_since;
+	host_if.timer_sleep = host_timer_sleep;
+	host_if.read_eeprom_var = host_read_eeprom_var;
+	host_if.store_eeprom_var = host_store_eeprom_var;
+	host_if.imu_get_quaternions = host_imu_get_quaternions;
+}
+
+bool vesc_host_load(bool (*init_fun)(lib_info *info)) {
+	memset(&info, 0, sizeof(info));
+	loaded = init_fun(&info);
+	return loaded;
+}
+
+void vesc_host_unload(void) {
+	if (loaded && info.stop_fun) {
+		info.stop_fun(info.arg);
+	}
+	loaded = false;
+}
+
+extension_fptr vesc_host_get_extension(const char *name) {
+	for (int i = 0;i < extension_num;i++) {
+		if (strcmp(extensions[i].name, name) == 0) {
+			return extensions[i].fun;
+		}
+	}
+	return 0;
+}
+
+// Calls an extension like the evaluator does. If it blocks the context, this
+// waits until the context is unblocked and returns the value from then.
+lbm_value vesc_host_call(const char *name, lbm_value *args, lbm_uint argn) {
+	extension_fptr fun = vesc_host_get_extension(name);
+	if (!fun) {
+		return host_if.lbm_enc_sym_eerror;
+	}
+
+	pthread_mutex_lock(&block_mutex);
+	blocked = false;
+	unblocked = false;
+	pthread_mutex_unlock(&block_mutex);
+
+	error_reason = 0;
+	lbm_value res = fun(args, argn);
+
+	pthread_mutex_lock(&block_mutex);
+	if (blocked) {
+		while (!unblocked) {
+			pthread_cond_wait(&block_cond, &block_mutex);
+		}
+		res = unblock_value;
+	}
+	pthread_mutex_unlock(&block_mutex);
+
+	return res;
+}
+
+const char *vesc_host_error_reason(void) {
+	return error_reason;
+}
+
+lbm_value vesc_host_str(const char *str) {
+	return vesc_host_bytes((const uint8_t*)str, strlen(str) + 1);
+}
+
+lbm_value vesc_host_bytes(const uint8_t *data, lbm_uint len) {
+	lbm_value res;
+	if (!host_lbm_create_byte_array(&res, len)) {
+		return host_if.lbm_enc_sym_merror;
+	}
+	memcpy(arrays[IND(res)].data, data, len);
+	return res;
+}
@@ -0,0 +1,53 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#ifndef VESC_HOST_H_
+#define VESC_HOST_H_
+
+#include "vesc_c_if.h"
+
+/*
+ * Host build
+ *
+ * With VESC_HOST_BUILD defined, VESC_IF points to a table that is filled in
+ * by this file instead of the firmware, so that libraries can be built with
+ * "make host" and run on a normal computer. Memory, threads, mutexes, time,
+ * printf, the EEPROM and a small part of LispBM are implemented. Every other
+ * function in the table returns zero, and tests can replace any entry before
+ * the library is loaded, e.g.
+ *
+ * VESC_IF->mc_get_rpm = my_rpm;
+ *
+ * LispBM values are 32 bits, so array headers are allocated in the lower 4 GB.
+ * Numbers and conses are kept in rings of slots that are reused, so values
+ * should not be kept for long.
+ */
+
+void vesc_host_init(void);
+bool vesc_host_load(bool (*init_fun)(lib_info *info));
+void vesc_host_unload(void);
+
+extension_fptr vesc_host_get_extension(const char *name);
+lbm_value vesc_host_call(const char *name, lbm_value *args, lbm_uint argn);
+const char *vesc_host_error_reason(void);
+
+lbm_value vesc_host_str(const char *str);
+lbm_value vesc_host_bytes(const uint8_t *data, lbm_uint len);
+
+#endif
@@ -3,6 +3,8 @@ CC = arm-none-eabi-gcc
 LD = arm-none-eabi-gcc
 OBJDUMP = arm-none-eabi-objdump
 OBJCOPY = arm-none-eabi-objcopy
+NM = arm-none-eabi-nm
+SIZE = arm-none-eabi-size
 PYTHON = python3
 
 STLIB_PATH = $(VESC_C_LIB_PATH)/stdperiph_stm32f4/
@@ -25,13 +27,29 @@ UTILS_PATH = $(VESC_C_LIB_PATH)/utils/
 
 SOURCES += $(UTILS_PATH)/rb.c
 
+# The other utilities are only built into the libraries that list them in
+# their Makefile, e.g.
+#
+# SOURCES += $(VESC_C_LIB_PATH)/utils/buffer.c
+
 OBJECTS = $(SOURCES:.c=.so)
 
 ifeq ($(USE_OPT),)
 	USE_OPT =
 endif
 
-CFLAGS = -fpic -Os -Wall -Wextra -Wundef -std=gnu99 -I$(VESC_C_LIB_PATH)
+# Optimization level for all files. Files can be built with a different level,
+# or with any other extra flags, by setting CFLAGS_<file name> in the Makefile
+# of the library, e.g.
+#
+# CFLAGS_balance_filter.c = -O2
+#
+# The extra flags come after CFLAGS, so they override the level below.
+ifeq ($(OPT_LEVEL),)
+	OPT_LEVEL = -Os
+endif
+
+CFLAGS = -fpic $(OPT_LEVEL) -Wall -Wextra -Wundef -std=gnu99 -I$(VESC_C_LIB_PATH)
 CFLAGS += -I$(STLIB_PATH)/CMSIS/include -I$(STLIB_PATH)/CMSIS/ST -I$(UTILS_PATH)/
 CFLAGS += -fomit-frame-pointer -falign-functions=16 -mthumb
 CFLAGS += -fsingle-precision-constant -Wdouble-promotion
@@ -48,13 +66,28 @@ LDFLAGS = -nostartfiles -static -mfloat-abi=hard -mfpu=fpv4-sp-d16 -mcpu=cortex-
 LDFLAGS += -lm -Wl,--gc-sections,--undefined=init
 LDFLAGS += -T $(VESC_C_LIB_PATH)/link.ld
 
-.PHONY: default all clean
+# Options for the generated .lisp-file, e.g. CONV_OPT = -d for decimal bytes,
+# which is about 30% smaller. Packages should import the .bin instead when
+# possible.
+ifeq ($(CONV_OPT),)
+	CONV_OPT =
+endif
+
+# Link-time optimization, enabled with USE_LTO = yes in the Makefile of the
+# library. GCC keeps the optimization level of every function from when it was
+# compiled, so CFLAGS_<file name> also works with LTO.
+ifeq ($(USE_LTO),yes)
+	CFLAGS += -flto
+	LDFLAGS += -flto $(OPT_LEVEL) -fpic -mthumb -ffunction-sections -fdata-sections
+endif
+
+.PHONY: default all clean size-report host
 
 default: $(TARGET)
 all: default
 
 %.so: %.c
-	$(CC) $(CFLAGS) -c $< -o $@
+	$(CC) $(CFLAGS) $(CFLAGS_$(notdir $<)) -c $< -o $@
 
 .PRECIOUS: $(TARGET) $(OBJECTS)
 
@@ -62,8 +95,42 @@ $(TARGET): $(OBJECTS)
 	$(LD) $(OBJECTS) $(LDFLAGS) -o $@.elf
 	$(OBJDUMP) -D $@.elf > $@.list
 	$(OBJCOPY) -O binary $@.elf $@.bin --gap-fill 0x00
-	$(PYTHON) $(VESC_C_LIB_PATH)/conv.py -f $@.bin -n $@ > $@.lisp
+	$(PYTHON) $(VESC_C_LIB_PATH)/conv.py $(CONV_OPT) -f $@.bin -n $@ > $@.lisp
+
+# Host build, see host/vesc_host.h. Builds the library and the mocked VESC_IF
+# into $(TARGET)_host.a with the compiler of the computer, so that it can be
+# linked into tests and benchmarks. Sanitizers and other flags can be added
+# with HOST_OPT, e.g. make host HOST_OPT=-fsanitize=address.
+HOST_CC = cc
+HOST_AR = ar
+HOST_PATH = $(VESC_C_LIB_PATH)/host/
+HOST_OBJECTS = $(SOURCES:.c=.host.o) $(HOST_PATH)/vesc_host.host.o
+
+HOST_CFLAGS = -O2 -g -Wall -Wextra -Wundef -std=gnu99 -I$(VESC_C_LIB_PATH)
+HOST_CFLAGS += -I$(STLIB_PATH)/CMSIS/include -I$(STLIB_PATH)/CMSIS/ST -I$(UTILS_PATH)/ -I$(HOST_PATH)/
+HOST_CFLAGS += -fsingle-precision-constant -Wdouble-promotion
+HOST_CFLAGS += -Wno-pointer-to-int-cast -Wno-int-to-pointer-cast
+HOST_CFLAGS += -DIS_VESC_LIB -DVESC_HOST_BUILD
+HOST_CFLAGS += $(HOST_OPT)
+
+ifeq ($(USE_STLIB),yes)
+	HOST_CFLAGS += -DUSE_STLIB -I$(STLIB_PATH)/inc
+endif
+
+host: $(TARGET)_host.a
+
+%.host.o: %.c
+	$(HOST_CC) $(HOST_CFLAGS) $(CFLAGS_$(notdir $<)) -c $< -o $@
+
+$(TARGET)_host.a: $(HOST_OBJECTS)
+	rm -f $@
+	$(HOST_AR) rcs $@ $(HOST_OBJECTS)
+
+# Prints the largest symbols and the usage of the MEM region from link.ld
+size-report: $(TARGET)
+	$(PYTHON) $(VESC_C_LIB_PATH)/size_report.py -f $(TARGET).elf -l $(VESC_C_LIB_PATH)/link.ld --nm $(NM) --size $(SIZE)
 
 clean:
 	rm -f $(OBJECTS) $(TARGET).elf $(TARGET).list $(TARGET).lisp $(TARGET).bin
+	rm -f $(HOST_OBJECTS) $(TARGET)_host.a
 
@@ -0,0 +1,81 @@
+import sys,getopt,re,subprocess
+
+filename = ""
+linkfile = "link.ld"
+nm = "arm-none-eabi-nm"
+size = "arm-none-eabi-size"
+num = 30
+
+opts,args = getopt.getopt(sys.argv[1:],'f:l:n:',['nm=','size='])
+for o,a in opts:
+	if o == '-f':
+		filename = a
+	if o == '-l':
+		linkfile = a
+	if o == '-n':
+		num = int(a)
+	if o == '--nm':
+		nm = a
+	if o == '--size':
+		size = a
+
+# Length of the MEM region
+mem_len = 64 * 1024
+with open(linkfile, "r") as f:
+	m = re.search(r'MEM\s*:\s*org\s*=\s*\w+\s*,\s*len\s*=\s*(\w+)', f.read())
+	if m:
+		l = m.group(1)
+		if l[-1] in "kK":
+			mem_len = int(l[:-1], 0) * 1024
+		else:
+			mem_len = int(l, 0)
+
+# Sections
+out = subprocess.check_output([size, "-A", "-d", filename]).decode()
+sections = []
+for line in out.splitlines():
+	p = line.split()
+	if len(p) == 3 and p[0].startswith(".") and p[1].isdigit():
+		sections.append((p[0], int(p[1]), int(p[2])))
+
+used = 0
+for s in sections:
+	# Everything that is placed in MEM has an address within it
+	if s[1] > 0 and s[2] < mem_len:
+		used = max(used, s[2] + s[1])
+
+# Symbols
+out = subprocess.check_output([nm, "-S", "--size-sort", "-r", "-t", "d", filename]).decode()
+text = []
+data = []
+for line in out.splitlines():
+	p = line.split()
+	if len(p) != 4:
+		continue
+	sym = (p[3], int(p[1], 10), p[2])
+	# link.ld places .rodata in .text, so read-only symbols count as text
+	if p[2] in "tTwWrR":
+		text.append(sym)
+	elif p[2] in "dDbB":
+		data.append(sym)
+
+def print_syms(title, syms):
+	print(title)
+	total = sum(s[1] for s in syms)
+	for s in syms[:num]:
+		print("  {:>6} {:5.1f}%  {}".format(s[1], 100.0 * s[1] / max(total, 1), s[0]))
+	if len(syms) > num:
+		print("  ... {} more".format(len(syms) - num))
+	print("  {:>6} total".format(total))
+	print("")
+
+print_syms("Text (code and constants):", text)
+print_syms("Data (initialized and zeroed):", data)
+
+print("Sections:")
+for s in sections:
+	if s[1] > 0:
+		print("  {:<20} {:>6}".format(s[0], s[1]))
+print("")
+print("MEM: {} of {} bytes used ({:.1f}%), {} bytes free".format(
+	used, mem_len, 100.0 * used / mem_len, mem_len - used))
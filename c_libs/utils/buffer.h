@@ -0,0 +1,148 @@
+/*
+	Copyright 2016 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#ifndef BUFFER_H_
+#define BUFFER_H_
+
+#include <stdint.h>
+
+// Serialization of numbers in big-endian byte order. The hot functions are
+// inline so that they compile to a few instructions at the call site, and
+// buffer.c only contains the uncommon cases of the float32_auto format.
+
+typedef union {
+	float f;
+	uint32_t u;
+} buffer_float_bits;
+
+// Bits of 1.5e-38f, the smallest magnitude that is not flushed to zero by
+// buffer_append_float32_auto.
+#define BUFFER_FLOAT32_AUTO_MIN_BITS	0x00A355E6
+
+void buffer_append_float32_auto_special(uint8_t* buffer, float number, int32_t *index);
+float buffer_get_float32_auto_special(uint32_t res);
+
+static inline void buffer_append_int16(uint8_t* buffer, int16_t number, int32_t *index) {
+	buffer[(*index)++] = number >> 8;
+	buffer[(*index)++] = number;
+}
+
+static inline void buffer_append_uint16(uint8_t* buffer, uint16_t number, int32_t *index) {
+	buffer[(*index)++] = number >> 8;
+	buffer[(*index)++] = number;
+}
+
+static inline void buffer_append_int32(uint8_t* buffer, int32_t number, int32_t *index) {
+	buffer[(*index)++] = number >> 24;
+	buffer[(*index)++] = number >> 16;
+	buffer[(*index)++] = number >> 8;
+	buffer[(*index)++] = number;
+}
+
+static inline void buffer_append_uint32(uint8_t* buffer, uint32_t number, int32_t *index) {
+	buffer[(*index)++] = number >> 24;
+	buffer[(*index)++] = number >> 16;
+	buffer[(*index)++] = number >> 8;
+	buffer[(*index)++] = number;
+}
+
+static inline void buffer_append_float16(uint8_t* buffer, float number, float scale, int32_t *index) {
+	buffer_append_int16(buffer, (int16_t)(number * scale), index);
+}
+
+static inline void buffer_append_float32(uint8_t* buffer, float number, float scale, int32_t *index) {
+	buffer_append_int32(buffer, (int32_t)(number * scale), index);
+}
+
+/*
+ * For finite numbers that are not flushed to zero the float32_auto format is
+ * exactly the IEEE-754 representation of the number, so these are handled
+ * here by copying the bits. See buffer.c for the format and the other cases.
+ */
+static inline void buffer_append_float32_auto(uint8_t* buffer, float number, int32_t *index) {
+	buffer_float_bits fb;
+	fb.f = number;
+	uint32_t abs_bits = fb.u & 0x7FFFFFFF;
+
+	// The IEEE-754 representation is ordered for positive numbers, so the
+	// subnormal threshold can be compared on the bits.
+	if (abs_bits < BUFFER_FLOAT32_AUTO_MIN_BITS) {
+		buffer_append_uint32(buffer, 0, index);
+	} else if ((abs_bits >> 23) != 0xFF) {
+		buffer_append_uint32(buffer, fb.u, index);
+	} else {
+		buffer_append_float32_auto_special(buffer, number, index);
+	}
+}
+
+static inline int16_t buffer_get_int16(const uint8_t *buffer, int32_t *index) {
+	int16_t res =	((uint16_t) buffer[*index]) << 8 |
+					((uint16_t) buffer[*index + 1]);
+	*index += 2;
+	return res;
+}
+
+static inline uint16_t buffer_get_uint16(const uint8_t *buffer, int32_t *index) {
+	uint16_t res = 	((uint16_t) buffer[*index]) << 8 |
+					((uint16_t) buffer[*index + 1]);
+	*index += 2;
+	return res;
+}
+
+static inline int32_t buffer_get_int32(const uint8_t *buffer, int32_t *index) {
+	int32_t res =	((uint32_t) buffer[*index]) << 24 |
+					((uint32_t) buffer[*index + 1]) << 16 |
+					((uint32_t) buffer[*index + 2]) << 8 |
+					((uint32_t) buffer[*index + 3]);
+	*index += 4;
+	return res;
+}
+
+static inline uint32_t buffer_get_uint32(const uint8_t *buffer, int32_t *index) {
+	uint32_t res =	((uint32_t) buffer[*index]) << 24 |
+					((uint32_t) buffer[*index + 1]) << 16 |
+					((uint32_t) buffer[*index + 2]) << 8 |
+					((uint32_t) buffer[*index + 3]);
+	*index += 4;
+	return res;
+}
+
+static inline float buffer_get_float16(const uint8_t *buffer, float scale, int32_t *index) {
+	return (float)buffer_get_int16(buffer, index) / scale;
+}
+
+static inline float buffer_get_float32(const uint8_t *buffer, float scale, int32_t *index) {
+	return (float)buffer_get_int32(buffer, index) / scale;
+}
+
+static inline float buffer_get_float32_auto(const uint8_t *buffer, int32_t *index) {
+	uint32_t res = buffer_get_uint32(buffer, index);
+	uint32_t e = (res >> 23) & 0xFF;
+
+	// Normal numbers and zero, which is all the encoder produces
+	if ((e != 0 && e != 0xFF) || (res & 0x7FFFFFFF) == 0) {
+		buffer_float_bits fb;
+		fb.u = res;
+		return fb.f;
+	}
+
+	return buffer_get_float32_auto_special(res);
+}
+
+#endif /* BUFFER_H_ */
@@ -0,0 +1,210 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "conftable.h"
+#include "buffer.h"
+#include <string.h>
+
+static int32_t load_int(const conftable_field *f, const uint8_t *p) {
+	switch (f->size) {
+	case 1:
+		return f->type == CONFTABLE_I8 ? *(const int8_t*)p : *p;
+	case 2:
+		return f->type == CONFTABLE_I16 ? *(const int16_t*)p : *(const uint16_t*)p;
+	default:
+		return *(const int32_t*)p;
+	}
+}
+
+static void store_int(const conftable_field *f, uint8_t *p, int32_t v) {
+	switch (f->size) {
+	case 1:
+		if (f->type == CONFTABLE_BOOL) {
+			*(bool*)p = v != 0;
+		} else {
+			*p = v;
+		}
+		break;
+	case 2:
+		*(uint16_t*)p = v;
+		break;
+	default:
+		*(int32_t*)p = v;
+		break;
+	}
+}
+
+// Returns the new index. It is kept in a local variable, as the compiler would
+// otherwise have to reload it after every byte written to the buffer.
+static int32_t append_field(const conftable_field *f, uint8_t *buffer, int32_t index, const void *conf) {
+	const uint8_t *p = (const uint8_t*)conf + f->offset;
+	int32_t *ind = &index;
+
+	switch (f->type) {
+	case CONFTABLE_F16:
+		buffer_append_float16(buffer, *(const float*)p, f->scale, ind);
+		break;
+	case CONFTABLE_F32:
+		buffer_append_float32(buffer, *(const float*)p, f->scale, ind);
+		break;
+	case CONFTABLE_F32_AUTO:
+		buffer_append_float32_auto(buffer, *(const float*)p, ind);
+		break;
+	case CONFTABLE_U16:
+	case CONFTABLE_I16:
+		buffer_append_uint16(buffer, load_int(f, p), ind);
+		break;
+	case CONFTABLE_U32:
+	case CONFTABLE_I32:
+		buffer_append_uint32(buffer, load_int(f, p), ind);
+		break;
+	default:
+		buffer[(*ind)++] = load_int(f, p);
+		break;
+	}
+
+	return index;
+}
+
+static int32_t get_field(const conftable_field *f, const uint8_t *buffer, int32_t index, void *conf) {
+	uint8_t *p = (uint8_t*)conf + f->offset;
+	int32_t *ind = &index;
+
+	switch (f->type) {
+	case CONFTABLE_F16:
+		*(float*)p = buffer_get_float16(buffer, f->scale, ind);
+		break;
+	case CONFTABLE_F32:
+		*(float*)p = buffer_get_float32(buffer, f->scale, ind);
+		break;
+	case CONFTABLE_F32_AUTO:
+		*(float*)p = buffer_get_float32_auto(buffer, ind);
+		break;
+	case CONFTABLE_U16:
+		store_int(f, p, buffer_get_uint16(buffer, ind));
+		break;
+	case CONFTABLE_I16:
+		store_int(f, p, buffer_get_int16(buffer, ind));
+		break;
+	case CONFTABLE_U32:
+	case CONFTABLE_I32:
+		store_int(f, p, buffer_get_int32(buffer, ind));
+		break;
+	case CONFTABLE_I8:
+		store_int(f, p, (int8_t)buffer[(*ind)++]);
+		break;
+	default:
+		store_int(f, p, buffer[(*ind)++]);
+		break;
+	}
+
+	return index;
+}
+
+int conftable_field_wire_size(const conftable *t, int field) {
+	switch (t->fields[field].type) {
+	case CONFTABLE_U16:
+	case CONFTABLE_I16:
+	case CONFTABLE_F16:
+		return 2;
+	case CONFTABLE_U32:
+	case CONFTABLE_I32:
+	case CONFTABLE_F32:
+	case CONFTABLE_F32_AUTO:
+		return 4;
+	default:
+		return 1;
+	}
+}
+
+int32_t conftable_serialize(const conftable *t, uint8_t *buffer, const void *conf) {
+	int32_t ind = 0;
+	buffer_append_uint32(buffer, t->signature, &ind);
+
+	for (int i = 0;i < t->field_num;i++) {
+		ind = append_field(&t->fields[i], buffer, ind, conf);
+	}
+
+	return ind;
+}
+
+// Only the fields in mask are updated when it is not NULL, the other fields
+// are skipped in the buffer. Returns false without changing conf if the
+// signature does not match.
+bool conftable_deserialize(const conftable *t, const uint8_t *buffer, void *conf, const uint32_t *mask) {
+	int32_t ind = 0;
+
+	if (buffer_get_uint32(buffer, &ind) != t->signature) {
+		return false;
+	}
+
+	for (int i = 0;i < t->field_num;i++) {
+		if (mask && !CONFTABLE_MASK_IS_SET(mask, i)) {
+			ind += conftable_field_wire_size(t, i);
+			continue;
+		}
+
+		ind = get_field(&t->fields[i], buffer, ind, conf);
+	}
+
+	return true;
+}
+
+void conftable_set_defaults(const conftable *t, void *conf) {
+	for (int i = 0;i < t->field_num;i++) {
+		const conftable_field *f = &t->fields[i];
+		uint8_t *p = (uint8_t*)conf + f->offset;
+
+		if (f->type >= CONFTABLE_F16) {
+			*(float*)p = f->def.f;
+		} else {
+			store_int(f, p, f->def.i);
+		}
+	}
+}
+
+// Serializes a single field without the signature. Returns the number of bytes
+// written.
+int32_t conftable_serialize_field(const conftable *t, int field, uint8_t *buffer, const void *conf) {
+	return append_field(&t->fields[field], buffer, 0, conf);
+}
+
+int32_t conftable_deserialize_field(const conftable *t, int field, const uint8_t *buffer, void *conf) {
+	return get_field(&t->fields[field], buffer, 0, conf);
+}
+
+// Sets the bit in mask, which must have CONFTABLE_MASK_WORDS words, for every
+// field whose stored value differs between a and b. Returns the number of
+// fields that differ.
+int conftable_diff(const conftable *t, const void *a, const void *b, uint32_t *mask) {
+	int diff = 0;
+
+	memset(mask, 0, CONFTABLE_MASK_WORDS(t->field_num) * sizeof(uint32_t));
+
+	for (int i = 0;i < t->field_num;i++) {
+		const conftable_field *f = &t->fields[i];
+
+		if (memcmp((const uint8_t*)a + f->offset, (const uint8_t*)b + f->offset, f->size) != 0) {
+			CONFTABLE_MASK_SET(mask, i);
+			diff++;
+		}
+	}
+
+	return diff;
+}
@@ -0,0 +1,94 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#ifndef CONFTABLE_H_
+#define CONFTABLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Table driven configuration serialization
+ *
+ * Every serialized field of a configuration struct is described by one const
+ * entry with its offset, type and scale, in the order of the serialization.
+ * One loop then serializes, deserializes and sets defaults for the whole
+ * struct, which takes much less flash than one line of code per field. The
+ * tables are generated from settings.xml by c_libs/conftable.py. The format on
+ * the wire is the same as the code generated by VESC Tool.
+ *
+ * Fields are addressed by their index in the table, and sets of fields by a
+ * mask with one bit per index. That allows updating only some fields from a
+ * serialized buffer and finding out which fields differ between two configs.
+ *
+ * The conftable itself has to be filled in at runtime, e.g. on the stack, as
+ * libraries cannot relocate pointers in their static data.
+ */
+
+typedef enum {
+	CONFTABLE_BOOL = 0,
+	CONFTABLE_U8,
+	CONFTABLE_I8,
+	CONFTABLE_U16,
+	CONFTABLE_I16,
+	CONFTABLE_U32,
+	CONFTABLE_I32,
+	CONFTABLE_F16, // Scaled to int16
+	CONFTABLE_F32, // Scaled to int32
+	CONFTABLE_F32_AUTO
+} CONFTABLE_TYPE;
+
+typedef struct {
+	uint16_t offset;
+	uint8_t type;
+	uint8_t size; // Size of the member in the struct
+	float scale;
+	union {
+		float f;
+		int32_t i;
+	} def;
+} conftable_field;
+
+typedef struct {
+	uint32_t signature;
+	const conftable_field *fields;
+	uint16_t field_num;
+} conftable;
+
+// Entries for a member of the struct st. The default of the integer types is
+// used for bool and enum members too.
+#define CONFTABLE_INT(st, member, t, default) \
+	{offsetof(st, member), t, sizeof(((st*)0)->member), 0.0, {.i = (default)}}
+#define CONFTABLE_FLOAT(st, member, t, scale, default) \
+	{offsetof(st, member), t, sizeof(((st*)0)->member), scale, {.f = (default)}}
+
+#define CONFTABLE_MASK_WORDS(field_num)		(((field_num) + 31) / 32)
+#define CONFTABLE_MASK_SET(mask, field)		((mask)[(field) / 32] |= 1U << ((field) % 32))
+#define CONFTABLE_MASK_IS_SET(mask, field)	(((mask)[(field) / 32] >> ((field) % 32)) & 1U)
+
+int32_t conftable_serialize(const conftable *t, uint8_t *buffer, const void *conf);
+bool conftable_deserialize(const conftable *t, const uint8_t *buffer, void *conf, const uint32_t *mask);
+void conftable_set_defaults(const conftable *t, void *conf);
+int32_t conftable_serialize_field(const conftable *t, int field, uint8_t *buffer, const void *conf);
+int32_t conftable_deserialize_field(const conftable *t, int field, const uint8_t *buffer, void *conf);
+int conftable_field_wire_size(const conftable *t, int field);
+int conftable_diff(const conftable *t, const void *a, const void *b, uint32_t *mask);
+
+#endif /* CONFTABLE_H_ */
@@ -0,0 +1,80 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "fast_code.h"
+#include "vesc_c_if.h"
+
+#include <string.h>
+
+#ifdef VESC_HOST_BUILD
+// There is no link.ld on the host, so everything runs where it is
+static uint8_t __fast_text_start[1];
+#define __fast_text_end __fast_text_start
+#else
+// Defined in link.ld. They are hidden so that they are addressed relative to
+// the code and not through the GOT.
+extern uint8_t __fast_text_start[] __attribute__((visibility("hidden")));
+extern uint8_t __fast_text_end[] __attribute__((visibility("hidden")));
+#endif
+
+bool fast_code_load(fast_code_t *fc) {
+	fc->mem = 0;
+	fc->code = 0;
+
+	uint32_t len = __fast_text_end - __fast_text_start;
+	if (len == 0) {
+		return false;
+	}
+
+	// Same alignment as in link.ld, so that the literal pools stay aligned
+	fc->mem = VESC_IF->malloc(len + 16);
+	if (!fc->mem) {
+		return false;
+	}
+
+	fc->code = (uint8_t*)(((uintptr_t)fc->mem + 15) & ~15);
+	memcpy(fc->code, __fast_text_start, len);
+
+#ifndef VESC_HOST_BUILD
+	// Make sure that the copy is complete before anything is fetched from it
+	__asm volatile ("dsb\n\tisb" ::: "memory");
+#endif
+
+	return true;
+}
+
+// Must not be called while the copied functions can run
+void fast_code_free(fast_code_t *fc) {
+	if (fc->mem) {
+		VESC_IF->free(fc->mem);
+	}
+	fc->mem = 0;
+	fc->code = 0;
+}
+
+// Returns the copy of fn in RAM, or fn if it is not in .fast_text or if there is
+// no copy. The Thumb bit of fn is kept.
+void *fast_code_fn(fast_code_t *fc, void *fn) {
+	uintptr_t addr = (uintptr_t)fn & ~1;
+	if (!fc->code || addr < (uintptr_t)__fast_text_start || addr >= (uintptr_t)__fast_text_end) {
+		return fn;
+	}
+
+	return fc->code + ((uintptr_t)fn - (uintptr_t)__fast_text_start);
+}
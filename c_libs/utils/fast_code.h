@@ -0,0 +1,52 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#ifndef FAST_CODE_H_
+#define FAST_CODE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Code in RAM
+ *
+ * Functions marked with FAST_CODE are linked into the .fast_text section, which
+ * fast_code_load copies to RAM. After that fast_code_fn returns the address of
+ * the copy, so that hot functions can be called through a function pointer
+ * without flash wait states.
+ *
+ * The copy is at a different address than the rest of the library, so these
+ * functions may only call VESC_IF and other FAST_CODE functions, and must not
+ * use globals or static constants. Float math has to be inlined, e.g. sqrtf
+ * needs -fno-math-errno. If there is no memory for the copy the functions in
+ * flash are used.
+ */
+
+#define FAST_CODE		__attribute__((section(".fast_text"), noinline))
+
+typedef struct {
+	void *mem;
+	uint8_t *code;
+} fast_code_t;
+
+bool fast_code_load(fast_code_t *fc);
+void fast_code_free(fast_code_t *fc);
+void *fast_code_fn(fast_code_t *fc, void *fn);
+
+#endif
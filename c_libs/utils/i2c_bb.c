@@ -0,0 +1,196 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "i2c_bb.h"
+
+// Timeout for clock stretching in busy loop iterations
+#define STRETCH_TIMEOUT		10000
+
+static void i2c_delay(i2c_bb_state *s) {
+	for (volatile int i = 0;i < s->delay;i++) {
+		__asm volatile ("nop");
+	}
+}
+
+static void sda_high(i2c_bb_state *s) { s->sda_gpio->BSRR.H.set = 1 << s->sda_pin; }
+static void sda_low(i2c_bb_state *s) { s->sda_gpio->BSRR.H.clear = 1 << s->sda_pin; }
+static void scl_low(i2c_bb_state *s) { s->scl_gpio->BSRR.H.clear = 1 << s->scl_pin; }
+static bool sda_read(i2c_bb_state *s) { return s->sda_gpio->IDR & (1 << s->sda_pin); }
+static bool scl_read(i2c_bb_state *s) { return s->scl_gpio->IDR & (1 << s->scl_pin); }
+
+// Releases SCL and waits while the slave stretches the clock
+static bool scl_high(i2c_bb_state *s) {
+	s->scl_gpio->BSRR.H.set = 1 << s->scl_pin;
+
+	int timeout = STRETCH_TIMEOUT;
+	while (!scl_read(s)) {
+		if (--timeout <= 0) {
+			s->has_error = true;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void start_cond(i2c_bb_state *s) {
+	if (s->has_started) {
+		// Repeated start
+		sda_high(s);
+		i2c_delay(s);
+		scl_high(s);
+		i2c_delay(s);
+	}
+
+	if (!sda_read(s)) {
+		s->has_error = true;
+	}
+
+	sda_low(s);
+	i2c_delay(s);
+	scl_low(s);
+	s->has_started = true;
+}
+
+static void stop_cond(i2c_bb_state *s) {
+	sda_low(s);
+	i2c_delay(s);
+	scl_high(s);
+	i2c_delay(s);
+	sda_high(s);
+	i2c_delay(s);
+	s->has_started = false;
+}
+
+static void write_bit(i2c_bb_state *s, bool bit) {
+	if (bit) {
+		sda_high(s);
+	} else {
+		sda_low(s);
+	}
+
+	i2c_delay(s);
+	scl_high(s);
+	i2c_delay(s);
+	scl_low(s);
+}
+
+static bool read_bit(i2c_bb_state *s) {
+	sda_high(s);
+	i2c_delay(s);
+	scl_high(s);
+	i2c_delay(s);
+	bool bit = sda_read(s);
+	scl_low(s);
+	return bit;
+}
+
+// Returns true if the byte was acknowledged
+static bool write_byte(i2c_bb_state *s, uint8_t byte) {
+	for (int i = 0;i < 8;i++) {
+		write_bit(s, byte & 0x80);
+		byte <<= 1;
+	}
+
+	return !read_bit(s);
+}
+
+static uint8_t read_byte(i2c_bb_state *s, bool ack) {
+	uint8_t byte = 0;
+	for (int i = 0;i < 8;i++) {
+		byte = (byte << 1) | read_bit(s);
+	}
+
+	write_bit(s, !ack);
+	return byte;
+}
+
+// Sets up the pins as open-drain outputs. The rate is approximate, as the delay
+// is a busy loop.
+void i2c_bb_init(i2c_bb_state *s, void *sda_gpio, uint32_t sda_pin,
+		void *scl_gpio, uint32_t scl_pin, uint32_t rate) {
+	s->sda_gpio = (stm32_gpio_t*)sda_gpio;
+	s->sda_pin = sda_pin;
+	s->scl_gpio = (stm32_gpio_t*)scl_gpio;
+	s->scl_pin = scl_pin;
+	s->has_started = false;
+	s->has_error = false;
+
+	// Roughly 8 cycles per iteration at 168 MHz
+	s->delay = rate > 0 ? (int)(10500000 / rate) : 26;
+
+	uint32_t mode = PAL_STM32_MODE_OUTPUT | PAL_STM32_OTYPE_OPENDRAIN |
+			PAL_STM32_OSPEED_MID1 | PAL_STM32_PUDR_PULLUP;
+	VESC_IF->set_pad_mode(sda_gpio, sda_pin, mode);
+	VESC_IF->set_pad_mode(scl_gpio, scl_pin, mode);
+
+	i2c_bb_restore_bus(s);
+}
+
+// Clocks out a slave that was interrupted in the middle of a transfer and
+// holds SDA low.
+void i2c_bb_restore_bus(i2c_bb_state *s) {
+	sda_high(s);
+	scl_high(s);
+	i2c_delay(s);
+
+	for (int i = 0;i < 16;i++) {
+		scl_low(s);
+		i2c_delay(s);
+		scl_high(s);
+		i2c_delay(s);
+	}
+
+	s->has_started = true;
+	stop_cond(s);
+	s->has_error = false;
+}
+
+// Writes txbytes and then reads rxbytes with a repeated start. Either of them can
+// be 0. Returns false on a missing acknowledge or a bus error.
+bool i2c_bb_tx_rx(i2c_bb_state *s, uint16_t addr, const uint8_t *txbuf, size_t txbytes,
+		uint8_t *rxbuf, size_t rxbytes) {
+	s->has_error = false;
+	bool ok = true;
+
+	if (txbytes > 0) {
+		start_cond(s);
+		ok = write_byte(s, addr << 1);
+		for (size_t i = 0;i < txbytes && ok;i++) {
+			ok = write_byte(s, txbuf[i]);
+		}
+	}
+
+	if (ok && rxbytes > 0) {
+		start_cond(s);
+		ok = write_byte(s, (addr << 1) | 1);
+		for (size_t i = 0;i < rxbytes && ok;i++) {
+			rxbuf[i] = read_byte(s, i < (rxbytes - 1));
+		}
+	}
+
+	stop_cond(s);
+
+	if (!ok || s->has_error) {
+		i2c_bb_restore_bus(s);
+		return false;
+	}
+
+	return true;
+}
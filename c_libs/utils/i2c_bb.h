@@ -0,0 +1,52 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#ifndef I2C_BB_H_
+#define I2C_BB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "st_types.h"
+#include "vesc_c_if.h"
+
+/*
+ * Bit-banged I2C master
+ *
+ * The C interface has no I2C functions, so this drives two open-drain pins
+ * directly, the same way as i2c-start in LispBM does. The pins should have
+ * pull-up resistors. Only one library or script can use the pins at a time.
+ */
+
+typedef struct {
+	stm32_gpio_t *sda_gpio;
+	uint32_t sda_pin;
+	stm32_gpio_t *scl_gpio;
+	uint32_t scl_pin;
+	int delay; // Busy loop iterations per half clock period
+	bool has_started;
+	bool has_error;
+} i2c_bb_state;
+
+void i2c_bb_init(i2c_bb_state *s, void *sda_gpio, uint32_t sda_pin,
+		void *scl_gpio, uint32_t scl_pin, uint32_t rate);
+void i2c_bb_restore_bus(i2c_bb_state *s);
+bool i2c_bb_tx_rx(i2c_bb_state *s, uint16_t addr, const uint8_t *txbuf, size_t txbytes,
+		uint8_t *rxbuf, size_t rxbytes);
+
+#endif
@@ -0,0 +1,144 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "log_codec.h"
+#include <math.h>
+
+static int32_t quantize(float value, float scale) {
+	float q = roundf(value * scale);
+
+	// Also catches NaN, which fails both comparisons
+	if (!(q > -2147483520.0) || !(q < 2147483520.0)) {
+		return q > 0.0 ? INT32_MAX : (q < 0.0 ? INT32_MIN : 0);
+	}
+
+	return (int32_t)q;
+}
+
+static void append_varint(uint8_t *buffer, uint32_t number, int32_t *index) {
+	while (number >= 0x80) {
+		buffer[(*index)++] = (number & 0x7F) | 0x80;
+		number >>= 7;
+	}
+	buffer[(*index)++] = number;
+}
+
+static bool get_varint(const uint8_t *buffer, int32_t len, int32_t *index, uint32_t *number) {
+	uint32_t res = 0;
+
+	for (int shift = 0;shift < 35;shift += 7) {
+		if (*index >= len) {
+			return false;
+		}
+
+		uint8_t b = buffer[(*index)++];
+		res |= (uint32_t)(b & 0x7F) << shift;
+
+		if (!(b & 0x80)) {
+			*number = res;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void log_codec_init(log_codec_t *c, int field_num, float *scale, int32_t *prev, int key_interval) {
+	c->field_num = field_num;
+	c->scale = scale;
+	c->prev = prev;
+	c->key_interval = key_interval;
+	log_codec_reset(c);
+}
+
+/*
+ * Makes the next encoded frame a key frame. Call this after frames have been lost
+ * on the decoder side.
+ */
+void log_codec_reset(log_codec_t *c) {
+	c->frame_cnt = 0;
+	for (int i = 0;i < c->field_num;i++) {
+		c->prev[i] = 0;
+	}
+}
+
+/*
+ * Appends one frame to buffer, which must have space for
+ * LOG_CODEC_MAX_LEN(field_num) bytes. Returns the number of bytes written.
+ */
+int32_t log_codec_append_frame(log_codec_t *c, const float *values, uint8_t *buffer, int32_t *index) {
+	int32_t start = *index;
+
+	bool key = c->frame_cnt == 0;
+	if (key) {
+		for (int i = 0;i < c->field_num;i++) {
+			c->prev[i] = 0;
+		}
+	}
+
+	c->frame_cnt++;
+	if (c->key_interval > 0 && c->frame_cnt >= c->key_interval) {
+		c->frame_cnt = 0;
+	}
+
+	buffer[(*index)++] = key ? LOG_CODEC_KEY : LOG_CODEC_DELTA;
+
+	for (int i = 0;i < c->field_num;i++) {
+		int32_t q = quantize(values[i], c->scale[i]);
+		uint32_t diff = (uint32_t)q - (uint32_t)c->prev[i];
+		append_varint(buffer, (diff << 1) ^ (uint32_t)-(int32_t)(diff >> 31), index);
+		c->prev[i] = q;
+	}
+
+	return *index - start;
+}
+
+/*
+ * Decodes one frame from buffer into values. Returns false if the frame is
+ * truncated or if it is a delta frame and no key frame has been seen.
+ */
+bool log_codec_get_frame(log_codec_t *c, const uint8_t *buffer, int32_t len, int32_t *index, float *values) {
+	if (*index >= len) {
+		return false;
+	}
+
+	uint8_t header = buffer[(*index)++];
+
+	if (header == LOG_CODEC_KEY) {
+		for (int i = 0;i < c->field_num;i++) {
+			c->prev[i] = 0;
+		}
+		c->frame_cnt = 1;
+	} else if (header != LOG_CODEC_DELTA || c->frame_cnt == 0) {
+		return false;
+	}
+
+	for (int i = 0;i < c->field_num;i++) {
+		uint32_t zz;
+		if (!get_varint(buffer, len, index, &zz)) {
+			return false;
+		}
+
+		uint32_t diff = (zz >> 1) ^ (uint32_t)-(int32_t)(zz & 1);
+		c->prev[i] = (int32_t)((uint32_t)c->prev[i] + diff);
+		values[i] = (float)c->prev[i] / c->scale[i];
+	}
+
+	return true;
+}
@@ -0,0 +1,60 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#ifndef LOG_CODEC_H_
+#define LOG_CODEC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Compressed log frames
+ *
+ * Every field is quantized to an integer with its own scale, and the difference
+ * to the same field in the previous frame is stored as a zigzag-encoded varint.
+ * A frame starts with one header byte:
+ *
+ * LOG_CODEC_KEY:   The differences are to 0, so the frame can be decoded on its own.
+ * LOG_CODEC_DELTA: The differences are to the previous frame.
+ *
+ * Slow signals and counters mostly take one byte per field this way. This file
+ * does not depend on the firmware, so the same code can be used on the host to
+ * decode the logs. The round-trip tests are in c_libs/bench/test_log_codec.c.
+ */
+
+#define LOG_CODEC_DELTA			0
+#define LOG_CODEC_KEY			1
+
+// Worst case size of an encoded frame
+#define LOG_CODEC_MAX_LEN(fields)	(1 + 5 * (fields))
+
+typedef struct {
+	int field_num;
+	float *scale; // Quantization scale per field, e.g. 100 for 2 decimals
+	int32_t *prev; // Previous quantized values
+	int key_interval; // Frames between key frames, 0 for only the first frame
+	int frame_cnt;
+} log_codec_t;
+
+void log_codec_init(log_codec_t *c, int field_num, float *scale, int32_t *prev, int key_interval);
+void log_codec_reset(log_codec_t *c);
+int32_t log_codec_append_frame(log_codec_t *c, const float *values, uint8_t *buffer, int32_t *index);
+bool log_codec_get_frame(log_codec_t *c, const uint8_t *buffer, int32_t len, int32_t *index, float *values);
+
+#endif /* LOG_CODEC_H_ */
@@ -0,0 +1,258 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "regmap.h"
+#include <string.h>
+
+// Compiles the field table into masks and shifts. The tables are not copied, so
+// they must stay valid.
+bool regmap_init(regmap_t *m, i2c_bb_state *i2c, uint16_t dev_addr,
+		const regmap_reg_desc *regs, int reg_num, const regmap_field_desc *fields, int field_num) {
+	m->i2c = i2c;
+	m->dev_addr = dev_addr;
+	m->regs = regs;
+	m->reg_num = reg_num;
+	m->field_desc = fields;
+	m->field_num = field_num;
+
+	m->fields = VESC_IF->malloc(field_num * sizeof(regmap_field));
+	m->shadow = VESC_IF->malloc(reg_num * sizeof(uint32_t));
+	m->valid = VESC_IF->malloc(reg_num * sizeof(bool));
+
+	if (!m->fields || !m->shadow || !m->valid) {
+		regmap_free(m);
+		return false;
+	}
+
+	for (int i = 0;i < field_num;i++) {
+		m->fields[i].reg = fields[i].reg;
+		m->fields[i].shift = fields[i].offset;
+		m->fields[i].mask = fields[i].bits >= 32 ? 0xFFFFFFFF : ((1u << fields[i].bits) - 1);
+	}
+
+	memset(m->shadow, 0, reg_num * sizeof(uint32_t));
+	regmap_invalidate(m);
+
+	return true;
+}
+
+void regmap_free(regmap_t *m) {
+	if (m->fields) {
+		VESC_IF->free(m->fields);
+	}
+	if (m->shadow) {
+		VESC_IF->free(m->shadow);
+	}
+	if (m->valid) {
+		VESC_IF->free(m->valid);
+	}
+
+	m->fields = 0;
+	m->shadow = 0;
+	m->valid = 0;
+}
+
+// Forgets the shadow copy, e.g. after the device has been reset
+void regmap_invalidate(regmap_t *m) {
+	memset(m->valid, 0, m->reg_num * sizeof(bool));
+}
+
+// Case-insensitive lookup, so that the names can come from LispBM. Returns -1
+// if there is no such field.
+int regmap_find_field(regmap_t *m, const char *name) {
+	for (int i = 0;i < m->field_num;i++) {
+		const char *a = m->field_desc[i].name;
+		const char *b = name;
+		int j = 0;
+
+		while (j < REGMAP_NAME_LEN && a[j] && b[j]) {
+			char ca = (a[j] >= 'a' && a[j] <= 'z') ? a[j] - 32 : a[j];
+			char cb = (b[j] >= 'a' && b[j] <= 'z') ? b[j] - 32 : b[j];
+			if (ca != cb) {
+				break;
+			}
+			j++;
+		}
+
+		if ((j == REGMAP_NAME_LEN || !a[j]) && !b[j]) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static uint32_t get_be(const uint8_t *buf, int len) {
+	uint32_t res = 0;
+	for (int i = 0;i < len;i++) {
+		res = (res << 8) | buf[i];
+	}
+	return res;
+}
+
+static void put_be(uint8_t *buf, uint32_t val, int len) {
+	for (int i = len - 1;i >= 0;i--) {
+		buf[i] = val;
+		val >>= 8;
+	}
+}
+
+// Reads the registers first_reg to last_reg into the shadow copy. Registers that
+// follow each other in the table are read in one burst as long as the span fits
+// in REGMAP_MAX_SPAN bytes, gaps between them are read and ignored.
+bool regmap_read(regmap_t *m, int first_reg, int last_reg) {
+	uint8_t buf[REGMAP_MAX_SPAN];
+
+	int start = first_reg;
+	while (start <= last_reg) {
+		uint8_t base = m->regs[start].addr;
+
+		// Extend the burst as far as possible
+		int end = start;
+		while (end < last_reg) {
+			const regmap_reg_desc *next = &m->regs[end + 1];
+			if (next->addr < base || (next->addr + next->len - base) > REGMAP_MAX_SPAN) {
+				break;
+			}
+			end++;
+		}
+
+		int span = m->regs[end].addr + m->regs[end].len - base;
+		if (!i2c_bb_tx_rx(m->i2c, m->dev_addr, &base, 1, buf, span)) {
+			return false;
+		}
+
+		for (int i = start;i <= end;i++) {
+			m->shadow[i] = get_be(buf + m->regs[i].addr - base, m->regs[i].len);
+			m->valid[i] = true;
+		}
+
+		start = end + 1;
+	}
+
+	return true;
+}
+
+// Gets a field, either from the shadow copy or by reading the register first.
+// The shadow copy is always read first if the register has not been read yet.
+bool regmap_get(regmap_t *m, int field, bool cached, uint32_t *value) {
+	if (field < 0 || field >= m->field_num) {
+		return false;
+	}
+
+	regmap_field *f = &m->fields[field];
+	if ((!cached || !m->valid[f->reg]) && !regmap_read(m, f->reg, f->reg)) {
+		return false;
+	}
+
+	*value = (m->shadow[f->reg] >> f->shift) & f->mask;
+	return true;
+}
+
+static bool write_span(regmap_t *m, int first_reg, int last_reg) {
+	uint8_t buf[REGMAP_MAX_SPAN + 1];
+	uint8_t base = m->regs[first_reg].addr;
+
+	buf[0] = base;
+	int len = 1;
+	for (int i = first_reg;i <= last_reg;i++) {
+		put_be(buf + 1 + m->regs[i].addr - base, m->shadow[i], m->regs[i].len);
+		len = 1 + m->regs[i].addr + m->regs[i].len - base;
+	}
+
+	return i2c_bb_tx_rx(m->i2c, m->dev_addr, buf, len, 0, 0);
+}
+
+// Sets a number of fields and writes the registers they are in. Registers that
+// have not been read yet are read first, after that only the shadow copy is
+// used. Registers that are next to each other in both the table and the address
+// space are written in one transaction.
+bool regmap_write_fields(regmap_t *m, const int *fields, const uint32_t *values, int num) {
+	int first = m->reg_num;
+	int last = -1;
+
+	for (int i = 0;i < num;i++) {
+		if (fields[i] < 0 || fields[i] >= m->field_num) {
+			return false;
+		}
+
+		int reg = m->fields[fields[i]].reg;
+		if (!m->valid[reg] && !regmap_read(m, reg, reg)) {
+			return false;
+		}
+
+		first = reg < first ? reg : first;
+		last = reg > last ? reg : last;
+	}
+
+	// Registers that are touched
+	bool touched[last >= 0 ? (last - first + 1) : 1];
+	memset(touched, 0, sizeof(touched));
+
+	for (int i = 0;i < num;i++) {
+		regmap_field *f = &m->fields[fields[i]];
+		m->shadow[f->reg] &= ~(f->mask << f->shift);
+		m->shadow[f->reg] |= (values[i] & f->mask) << f->shift;
+		touched[f->reg - first] = true;
+	}
+
+	int start = first;
+	while (start <= last) {
+		if (!touched[start - first]) {
+			start++;
+			continue;
+		}
+
+		int end = start;
+		while (end < last && touched[end + 1 - first] &&
+				m->regs[end + 1].addr == (m->regs[end].addr + m->regs[end].len) &&
+				(m->regs[end + 1].addr + m->regs[end + 1].len - m->regs[start].addr) <= REGMAP_MAX_SPAN) {
+			end++;
+		}
+
+		if (!write_span(m, start, end)) {
+			// The chip state is unknown now
+			for (int i = start;i <= end;i++) {
+				m->valid[i] = false;
+			}
+			return false;
+		}
+
+		start = end + 1;
+	}
+
+	return true;
+}
+
+// Writes a whole register
+bool regmap_write_reg(regmap_t *m, int reg, uint32_t value) {
+	if (reg < 0 || reg >= m->reg_num) {
+		return false;
+	}
+
+	m->shadow[reg] = value;
+	m->valid[reg] = true;
+
+	if (!write_span(m, reg, reg)) {
+		m->valid[reg] = false;
+		return false;
+	}
+
+	return true;
+}
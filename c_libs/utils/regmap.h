@@ -0,0 +1,82 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#ifndef REGMAP_H_
+#define REGMAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_bb.h"
+
+/*
+ * Register map for I2C peripherals
+ *
+ * A driver describes its registers and fields in two const tables. They are
+ * compiled into masks and shifts once, and the last value of every register is
+ * kept in a shadow copy. That way fields can be read without I2C traffic, and
+ * changing several fields only takes one write per register without reading it
+ * first. Multi-byte registers are big endian, which most I2C peripherals use.
+ */
+
+#define REGMAP_NAME_LEN		12
+#define REGMAP_MAX_SPAN		32 // Max bytes in one burst transfer
+
+typedef struct {
+	uint8_t addr;
+	uint8_t len; // Bytes, 1 to 4
+} regmap_reg_desc;
+
+typedef struct {
+	char name[REGMAP_NAME_LEN];
+	uint8_t reg; // Index in the register table
+	uint8_t offset;
+	uint8_t bits;
+} regmap_field_desc;
+
+typedef struct {
+	uint8_t reg;
+	uint8_t shift;
+	uint32_t mask; // Mask after the shift
+} regmap_field;
+
+typedef struct {
+	i2c_bb_state *i2c;
+	uint16_t dev_addr;
+
+	const regmap_reg_desc *regs;
+	int reg_num;
+	const regmap_field_desc *field_desc;
+	int field_num;
+
+	regmap_field *fields;
+	uint32_t *shadow;
+	bool *valid;
+} regmap_t;
+
+bool regmap_init(regmap_t *m, i2c_bb_state *i2c, uint16_t dev_addr,
+		const regmap_reg_desc *regs, int reg_num, const regmap_field_desc *fields, int field_num);
+void regmap_free(regmap_t *m);
+void regmap_invalidate(regmap_t *m);
+int regmap_find_field(regmap_t *m, const char *name);
+bool regmap_read(regmap_t *m, int first_reg, int last_reg);
+bool regmap_get(regmap_t *m, int field, bool cached, uint32_t *value);
+bool regmap_write_fields(regmap_t *m, const int *fields, const uint32_t *values, int num);
+bool regmap_write_reg(regmap_t *m, int reg, uint32_t value);
+
+#endif
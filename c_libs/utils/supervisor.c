@@ -0,0 +1,199 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#include "supervisor.h"
+#include <string.h>
+
+static float sample_source(uint8_t source) {
+	switch (source) {
+	case SUPERVISOR_SRC_VIN: return VESC_IF->mc_get_input_voltage_filtered();
+	case SUPERVISOR_SRC_TEMP_FET: return VESC_IF->mc_temp_fet_filtered();
+	case SUPERVISOR_SRC_TEMP_MOT: return VESC_IF->mc_temp_motor_filtered();
+	case SUPERVISOR_SRC_FAULT: return (float)VESC_IF->mc_get_fault();
+	default: return 0.0;
+	}
+}
+
+static void supervisor_thd(void *arg) {
+	supervisor_t *s = (supervisor_t*)arg;
+
+	// The values are sampled once per round, even if several monitors use them
+	float values[SUPERVISOR_SRC_NUM];
+	bool sampled[SUPERVISOR_SRC_NUM];
+
+	// Callbacks are called after the mutex is released
+	supervisor_monitor fired[SUPERVISOR_MAX_MONITORS];
+	int fired_id[SUPERVISOR_MAX_MONITORS];
+	float fired_val[SUPERVISOR_MAX_MONITORS];
+
+	while (!VESC_IF->should_terminate()) {
+		uint32_t round_start = VESC_IF->timer_time_now();
+		int fired_num = 0;
+
+		memset(sampled, 0, sizeof(sampled));
+
+		VESC_IF->mutex_lock(s->mutex);
+		for (int i = 0;i < SUPERVISOR_MAX_MONITORS;i++) {
+			supervisor_monitor *m = &s->monitors[i];
+			if (!m->used) {
+				continue;
+			}
+
+			if (!sampled[m->source]) {
+				values[m->source] = sample_source(m->source);
+				sampled[m->source] = true;
+			}
+
+			float v = values[m->source];
+			bool past = m->below ? v < m->threshold : v > m->threshold;
+			bool back = m->below ? v >= (m->threshold + m->hysteresis) :
+					v <= (m->threshold - m->hysteresis);
+
+			if (!m->fired && past) {
+				m->fired = true;
+				fired[fired_num] = *m;
+				fired_id[fired_num] = i;
+				fired_val[fired_num] = v;
+				fired_num++;
+			} else if (m->fired && back) {
+				m->fired = false;
+			}
+		}
+		float rate = s->rate;
+		VESC_IF->mutex_unlock(s->mutex);
+
+		for (int i = 0;i < fired_num;i++) {
+			if (fired[i].cb) {
+				fired[i].cb(fired_id[i], fired_val[i], fired[i].cb_arg);
+			}
+		}
+
+		if (s->tick_cb) {
+			s->tick_cb(s->tick_arg);
+		}
+
+		float left = 1.0 / rate - VESC_IF->timer_seconds_elapsed_since(round_start);
+		if (left > 0.0) {
+			VESC_IF->sleep_us((uint32_t)(left * 1.0e6));
+		}
+	}
+}
+
+void supervisor_init(supervisor_t *s, float rate) {
+	memset(s->monitors, 0, sizeof(s->monitors));
+	s->rate = rate;
+	s->tick_cb = 0;
+	s->tick_arg = 0;
+	s->thread = 0;
+	s->mutex = VESC_IF->mutex_create();
+}
+
+void supervisor_set_rate(supervisor_t *s, float rate) {
+	if (rate > 0.0) {
+		s->rate = rate;
+	}
+}
+
+// Must be set before the thread is started
+void supervisor_set_tick_cb(supervisor_t *s, supervisor_tick_cb cb, void *arg) {
+	s->tick_arg = arg;
+	s->tick_cb = cb;
+}
+
+// Adds a monitor on source that fires when the value goes above threshold, or
+// below it if below is set. Returns the id of the monitor, or -1 if all
+// monitors are in use.
+int supervisor_add(supervisor_t *s, SUPERVISOR_SRC source, bool below, float threshold,
+		float hysteresis, supervisor_cb cb, void *arg) {
+	if (source >= SUPERVISOR_SRC_NUM) {
+		return -1;
+	}
+
+	int id = -1;
+
+	VESC_IF->mutex_lock(s->mutex);
+	for (int i = 0;i < SUPERVISOR_MAX_MONITORS;i++) {
+		supervisor_monitor *m = &s->monitors[i];
+		if (!m->used) {
+			m->fired = false;
+			m->source = source;
+			m->below = below;
+			m->threshold = threshold;
+			m->hysteresis = hysteresis;
+			m->cb = cb;
+			m->cb_arg = arg;
+			m->used = true;
+			id = i;
+			break;
+		}
+	}
+	VESC_IF->mutex_unlock(s->mutex);
+
+	return id;
+}
+
+bool supervisor_remove(supervisor_t *s, int id) {
+	if (id < 0 || id >= SUPERVISOR_MAX_MONITORS) {
+		return false;
+	}
+
+	VESC_IF->mutex_lock(s->mutex);
+	bool res = s->monitors[id].used;
+	s->monitors[id].used = false;
+	VESC_IF->mutex_unlock(s->mutex);
+
+	return res;
+}
+
+// Arms a monitor that has fired, so that it fires again on the next round if the
+// value still is past the threshold.
+bool supervisor_rearm(supervisor_t *s, int id) {
+	if (id < 0 || id >= SUPERVISOR_MAX_MONITORS) {
+		return false;
+	}
+
+	VESC_IF->mutex_lock(s->mutex);
+	bool res = s->monitors[id].used;
+	s->monitors[id].fired = false;
+	VESC_IF->mutex_unlock(s->mutex);
+
+	return res;
+}
+
+bool supervisor_start(supervisor_t *s) {
+	// The thread keeps about 250 bytes of arrays on the stack and runs the
+	// callbacks, which also unblock LispBM contexts
+	if (!s->thread) {
+		s->thread = VESC_IF->spawn(supervisor_thd, 1024, "Supervisor", s);
+	}
+
+	return s->thread != 0;
+}
+
+void supervisor_stop(supervisor_t *s) {
+	if (s->thread) {
+		VESC_IF->request_terminate(s->thread);
+		s->thread = 0;
+	}
+}
+
+void supervisor_free(supervisor_t *s) {
+	supervisor_stop(s);
+	VESC_IF->free(s->mutex);
+}
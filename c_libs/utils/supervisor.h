@@ -0,0 +1,86 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    */
+
+#ifndef SUPERVISOR_H_
+#define SUPERVISOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "vesc_c_if.h"
+
+/*
+ * Supervisor
+ *
+ * One thread that checks a number of thresholds at a fixed rate, instead of one
+ * polling thread per threshold. A monitor fires its callback once when the value
+ * goes past the threshold, and is armed again when the value has come back by
+ * more than the hysteresis, or with supervisor_rearm. The callbacks run in the
+ * supervisor thread, so they should be short and must not add or remove monitors.
+ *
+ * lib_supervisor provides this to LispBM as a native library, so that scripts in
+ * different packages can share one thread. Libraries that need monitors in C
+ * can also add supervisor.c to SOURCES in their Makefile, which gives them their
+ * own thread and monitors.
+ */
+
+#define SUPERVISOR_MAX_MONITORS		8
+
+typedef enum {
+	SUPERVISOR_SRC_VIN = 0,
+	SUPERVISOR_SRC_TEMP_FET,
+	SUPERVISOR_SRC_TEMP_MOT,
+	SUPERVISOR_SRC_FAULT,
+	SUPERVISOR_SRC_NUM
+} SUPERVISOR_SRC;
+
+typedef void (*supervisor_cb)(int id, float value, void *arg);
+typedef void (*supervisor_tick_cb)(void *arg);
+
+typedef struct {
+	bool used;
+	bool fired;
+	uint8_t source;
+	bool below;
+	float threshold;
+	float hysteresis;
+	supervisor_cb cb;
+	void *cb_arg;
+} supervisor_monitor;
+
+typedef struct {
+	supervisor_monitor monitors[SUPERVISOR_MAX_MONITORS];
+	float rate;
+	supervisor_tick_cb tick_cb; // Called after every round, e.g. to retry work
+	void *tick_arg;
+	lib_thread thread;
+	lib_mutex mutex;
+} supervisor_t;
+
+void supervisor_init(supervisor_t *s, float rate);
+void supervisor_set_rate(supervisor_t *s, float rate);
+void supervisor_set_tick_cb(supervisor_t *s, supervisor_tick_cb cb, void *arg);
+int supervisor_add(supervisor_t *s, SUPERVISOR_SRC source, bool below, float threshold,
+		float hysteresis, supervisor_cb cb, void *arg);
+bool supervisor_remove(supervisor_t *s, int id);
+bool supervisor_rearm(supervisor_t *s, int id);
+bool supervisor_start(supervisor_t *s);
+void supervisor_stop(supervisor_t *s);
+void supervisor_free(supervisor_t *s);
+
+#endif
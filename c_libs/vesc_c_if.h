@@ -565,7 +565,13 @@ typedef struct {
 } lib_info;
 
 // VESC-interface with function pointers
+#ifdef VESC_HOST_BUILD
+// See host/vesc_host.h
+extern vesc_c_if *vesc_host_if;
+#define VESC_IF		vesc_host_if
+#else
 #define VESC_IF		((vesc_c_if*)(0x1000F800))
+#endif
 
 // Put this at the beginning of your source file
 #define HEADER		static volatile int __attribute__((__section__(".program_ptr"))) prog_ptr;
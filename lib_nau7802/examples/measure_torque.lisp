@@ -1,90 +1,70 @@
 ; See
 ; https://www.youtube.com/watch?v=H0oRhapKZnM
 
-(import "pkg@://vesc_packages/lib_nau7802/nau7802.vescpkg" 'nau7802)
-(eval-program (read-program nau7802))
-(nau-init)
+(import "pkg::nau7802@://vesc_packages/lib_nau7802/nau7802_native.vescpkg" 'nau7802)
+(load-native-lib nau7802)
+(ext-nau-init 320)
 
-; Run this function without any weight to calibrate the zero offset
-(defun zero-offset ()
-    (progn
-        (def adc-ofs 0.0)
-        (looprange i 0 100
-            (progn
-                (def adc-ofs (+ adc-ofs (nau-read-adc)))
-                (sleep 0.01)
-        ))
-        (def adc-ofs (/ adc-ofs 100.0))
-))
-
-(defun read-avg (samples)
-    (progn
-        (let ((avg 0))
-            (progn
-                (looprange it 0 samples
-                    (progn
-                        (setvar 'avg (+ avg (- (nau-read-adc) adc-ofs)))
-                        (sleep 0.01)
-                ))
-            (/ avg samples)
-))))
-
-; Used to calibrate scale. Put a known weight on the scale
-; and use this function with the weight as an argument.
-; zero-offset has to be run first.
-(defun cal-with-weight (weight)
-    (setvar 'scale (/ weight (read-avg 100)))
-)
-
-(defun read-grams ()
-    (* (- (nau-read-adc) adc-ofs) scale)
-)
-
-(defun lpf (val sample)
-    (- val (* 0.5 (- val sample)))
-)
+; Average over 8 samples followed by a 10 Hz low-pass filter. The samples
+; are filtered by the native library, so this script does not have to do
+; anything per sample.
+(ext-nau-filter 1 8 10.0)
 
-(def scale 21572.6) ; Factor to convert voltage to grams
-(def grams 0)       ; Weight in grams
-(def gramsf 0)      ; Filtered weight
+; Factor to convert the ADC value to grams. To calibrate it, run
+; (ext-nau-tare) without any weight, put a known weight on the scale
+; and run (ext-nau-cal-weight weight). (ext-nau-cal-store) saves the
+; calibration, so that (ext-nau-cal-load) can be used instead of this.
+(ext-nau-set-cal 0.0 21572.6)
 
-(zero-offset)
+; Zero offset, the load cell must be unloaded here
+(sleep 1.0)
+(ext-nau-tare 50)
 
-(defun calc-torque ()
+(defun calc-torque (current)
     (* 1.5 (conf-get 'si-motor-poles) 0.5
-    (get-current) (conf-get 'foc-motor-flux-linkage) 0.001)
+    current (conf-get 'foc-motor-flux-linkage) 0.001)
 )
 
-(spawn (fn () (loopwhile t
-            (progn
-                (def adc (nau-read-adc))
-                (def grams (read-grams))
-                (def gramsf (lpf gramsf grams))
-                (def torque (* (* gramsf -0.01) 0.0424))
-                (def torque-calc (calc-torque))
-                (sleep 0.01)
-))))
-
-(sleep 1.0)
-
 (plot-init "Current (A)" "Torque (Nm)")
 (plot-add-graph "Calculated")
 (plot-add-graph "Measured")
 (plot-add-graph "Ratio")
 
+; Every conversion is captured together with the motor current at the time
+; it completed, so the points line up even while the current changes. Each
+; point is 20 bytes with time, raw, filtered, current and erpm.
+(defun plot-capture ()
+    (let ((buf (ext-nau-capture-get)))
+        (loopwhile buf
+            (progn
+                (looprange i 0 (/ (buflen buf) 20)
+                    (let (
+                            (ofs (* i 20))
+                            (torque (* (bufget-f32 buf (+ ofs 4)) -0.01 0.0424))
+                            (current (bufget-f32 buf (+ ofs 12)))
+                            (torque-calc (calc-torque current))
+                        )
+                        (progn
+                            (plot-set-graph 0)
+                            (plot-send-points current torque-calc)
+                            (plot-set-graph 1)
+                            (plot-send-points current torque)
+                            (plot-set-graph 2)
+                            (plot-send-points current (/ torque torque-calc))
+                )))
+                (setvar 'buf (ext-nau-capture-get))
+))))
+
+(ext-nau-capture-start 1024)
+
 (looprange i 5 120
-    (let (
-            (i-now (* i 0.1))
-        )
-        (progn
-            (set-current i-now)
-            (looprange i 0 3 (progn (timeout-reset) (sleep 0.1)))
-            (plot-set-graph 0)
-            (plot-send-points i-now torque-calc)
-            (plot-set-graph 1)
-            (plot-send-points i-now torque)
-            (plot-set-graph 2)
-            (plot-send-points i-now (/ torque torque-calc))
-)))
+    (progn
+        (set-current (* i 0.1))
+        (timeout-reset)
+        (sleep 0.05)
+        (plot-capture)
+))
 
 (set-current 0)
+(ext-nau-capture-stop)
+(plot-capture)
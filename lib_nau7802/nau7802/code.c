@@ -0,0 +1,1162 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "st_types.h"
+#include "vesc_c_if.h"
+#include "i2c_bb.h"
+#include "regmap.h"
+#include "rb.h"
+
+#include <math.h>
+#include <string.h>
+
+HEADER
+
+#define NAU_I2C_ADDR		0x2A
+#define NAU_I2C_RATE		200000
+
+// Registers, in the same order as in regs below
+typedef enum {
+	R_PU_CTRL = 0,
+	R_CTRL1,
+	R_CTRL2,
+	R_OCAL1,
+	R_GCAL1,
+	R_OCAL2,
+	R_GCAL2,
+	R_I2C,
+	R_ADCO,
+	R_ADC_CONF,
+	R_PGA,
+	R_PWR,
+	R_NUM
+} Register;
+
+// Fields, in the same order as in fields below
+typedef enum {
+	F_RR = 0, F_PUD, F_PUA, F_PUR, F_CS, F_CR, F_OSCS, F_AVDDS,
+	F_GAINS, F_VLDO, F_DRDY_SEL, F_CRP,
+	F_CALMOD, F_CALS, F_CAL_ERR, F_CRS, F_CHS,
+	F_OFFSET1, F_NEG1, F_GAIN1, F_OFFSET2, F_NEG2, F_GAIN2,
+	F_BGPCP, F_TS, F_BOPGA, F_SI, F_WPD, F_SPE, F_FRD, F_CRSD,
+	F_ADC,
+	F_REG_CHP, F_ADC_VCM, F_REG_CHPS,
+	F_CHPDIS, F_PGAINV, F_BYPASS, F_OUTBUF, F_LDOMODE, F_RD_SEL,
+	F_PGACURR, F_ADCCURR, F_BIAS, F_CAPEN,
+	F_NUM
+} Field;
+
+// Same registers and fields as in nau7802.lisp. Fields that exist in both
+// calibration channels have the channel appended to the name.
+static const regmap_reg_desc regs[R_NUM] = {
+	[R_PU_CTRL] = {0x00, 1},
+	[R_CTRL1] = {0x01, 1},
+	[R_CTRL2] = {0x02, 1},
+	[R_OCAL1] = {0x03, 3},
+	[R_GCAL1] = {0x06, 4},
+	[R_OCAL2] = {0x0A, 3},
+	[R_GCAL2] = {0x0D, 4},
+	[R_I2C] = {0x11, 1},
+	[R_ADCO] = {0x12, 3},
+	[R_ADC_CONF] = {0x15, 1},
+	[R_PGA] = {0x1B, 1},
+	[R_PWR] = {0x1C, 1},
+};
+
+static const regmap_field_desc fields[F_NUM] = {
+	[F_RR] = {"RR", R_PU_CTRL, 0, 1},
+	[F_PUD] = {"PUD", R_PU_CTRL, 1, 1},
+	[F_PUA] = {"PUA", R_PU_CTRL, 2, 1},
+	[F_PUR] = {"PUR", R_PU_CTRL, 3, 1},
+	[F_CS] = {"CS", R_PU_CTRL, 4, 1},
+	[F_CR] = {"CR", R_PU_CTRL, 5, 1},
+	[F_OSCS] = {"OSCS", R_PU_CTRL, 6, 1},
+	[F_AVDDS] = {"AVDDS", R_PU_CTRL, 7, 1},
+	[F_GAINS] = {"GAINS", R_CTRL1, 0, 3},
+	[F_VLDO] = {"VLDO", R_CTRL1, 3, 3},
+	[F_DRDY_SEL] = {"DRDY-SEL", R_CTRL1, 6, 1},
+	[F_CRP] = {"CRP", R_CTRL1, 7, 1},
+	[F_CALMOD] = {"CALMOD", R_CTRL2, 0, 2},
+	[F_CALS] = {"CALS", R_CTRL2, 2, 1},
+	[F_CAL_ERR] = {"CAL-ERR", R_CTRL2, 3, 1},
+	[F_CRS] = {"CRS", R_CTRL2, 4, 3},
+	[F_CHS] = {"CHS", R_CTRL2, 7, 1},
+	[F_OFFSET1] = {"OFFSET1", R_OCAL1, 0, 23},
+	[F_NEG1] = {"NEG1", R_OCAL1, 23, 1},
+	[F_GAIN1] = {"GAIN1", R_GCAL1, 0, 32},
+	[F_OFFSET2] = {"OFFSET2", R_OCAL2, 0, 23},
+	[F_NEG2] = {"NEG2", R_OCAL2, 23, 1},
+	[F_GAIN2] = {"GAIN2", R_GCAL2, 0, 32},
+	[F_BGPCP] = {"BGPCP", R_I2C, 0, 1},
+	[F_TS] = {"TS", R_I2C, 1, 1},
+	[F_BOPGA] = {"BOPGA", R_I2C, 2, 1},
+	[F_SI] = {"SI", R_I2C, 3, 1},
+	[F_WPD] = {"WPD", R_I2C, 4, 1},
+	[F_SPE] = {"SPE", R_I2C, 5, 1},
+	[F_FRD] = {"FRD", R_I2C, 6, 1},
+	[F_CRSD] = {"CRSD", R_I2C, 7, 1},
+	[F_ADC] = {"ADC", R_ADCO, 0, 24},
+	[F_REG_CHP] = {"REG-CHP", R_ADC_CONF, 0, 2},
+	[F_ADC_VCM] = {"ADC-VCM", R_ADC_CONF, 2, 2},
+	[F_REG_CHPS] = {"REG-CHPS", R_ADC_CONF, 4, 2},
+	[F_CHPDIS] = {"CHPDIS", R_PGA, 0, 1},
+	[F_PGAINV] = {"PGAINV", R_PGA, 3, 1},
+	[F_BYPASS] = {"BYPASS", R_PGA, 4, 1},
+	[F_OUTBUF] = {"OUTBUF", R_PGA, 5, 1},
+	[F_LDOMODE] = {"LDOMODE", R_PGA, 6, 1},
+	[F_RD_SEL] = {"RD-SEL", R_PGA, 7, 1},
+	[F_PGACURR] = {"PGACURR", R_PWR, 0, 2},
+	[F_ADCCURR] = {"ADCCURR", R_PWR, 2, 2},
+	[F_BIAS] = {"BIAS", R_PWR, 4, 3},
+	[F_CAPEN] = {"CAPEN", R_PWR, 7, 1},
+};
+
+#define FIELD_BIT(f)		(1 << fields[f].offset)
+
+// Max fields in one ext-nau-reg-set
+#define REG_SET_MAX			8
+
+// Samples are written by the sampling thread only, and read without locks by
+// the extensions. The length must be a power of two.
+#define SAMPLE_BUF_LEN		64
+#define SAMPLE_BUF_MASK		(SAMPLE_BUF_LEN - 1)
+
+// Scale to the same range as nau-read-adc in nau7802.lisp
+#define ADC_SCALE			(1.0 / 8388608.0)
+
+// Filter windows
+#define MAX_AVG_WINDOW		32
+#define MAX_MEDIAN_WINDOW	15
+
+// Synchronized capture
+#define CAPTURE_DEFAULT_LEN	256
+#define CAPTURE_POINT_LEN	20 // Bytes per point in ext-nau-capture-get
+#define CAPTURE_MAX_GET		64
+
+// Calibration in EEPROM
+#define CAL_MAGIC			0x4E415531 // NAU1
+#define CAL_DEFAULT_ADDR	61
+
+typedef struct{
+	float a0, a1, a2, b1, b2;
+	float z1, z2;
+} Biquad;
+
+typedef enum {
+	PRE_FILTER_NONE = 0,
+	PRE_FILTER_AVERAGE,
+	PRE_FILTER_MEDIAN
+} PreFilter;
+
+// Filter and calibration. Changed by the extensions and applied by the sampling
+// thread before the next sample.
+typedef struct {
+	PreFilter pre_filter;
+	int window;
+	float lp_hz;
+	float tare;
+	float scale;
+} pipeline_cfg;
+
+// One conversion together with the motor state at the time it completed
+typedef struct {
+	float time;
+	float raw; // Raw sample with the calibration applied
+	float filtered;
+	float current;
+	float erpm;
+} capture_point;
+
+typedef struct {
+	i2c_bb_state i2c;
+	regmap_t regmap;
+	lib_mutex bus_mutex; // The extensions can access registers while sampling
+
+	// Optional DRDY pin, otherwise the CR bit is polled
+	stm32_gpio_t *drdy_gpio;
+	uint32_t drdy_pin;
+
+	float rate;
+	int gains;
+	int crs;
+	lib_thread thread;
+	int init_cid;
+
+	int32_t samples[SAMPLE_BUF_LEN];
+	float filtered[SAMPLE_BUF_LEN]; // Same index as samples
+	volatile uint32_t sample_cnt;
+	volatile uint32_t error_cnt;
+
+	// Pipeline
+	pipeline_cfg cfg; // Used by the sampling thread
+	pipeline_cfg cfg_new;
+	volatile bool cfg_changed;
+	lib_mutex cfg_mutex;
+	Biquad lp;
+
+	// Read positions of ext-nau-get-new
+	uint32_t read_raw;
+	uint32_t read_filtered;
+
+	// Capture
+	rb_t capture;
+	volatile bool capturing;
+	lib_mutex capture_mutex;
+	uint32_t capture_start;
+	volatile uint32_t capture_dropped;
+} data;
+
+static float biquad_process(Biquad *biquad, float in) {
+    float out = in * biquad->a0 + biquad->z1;
+    biquad->z1 = in * biquad->a1 + biquad->z2 - biquad->b1 * out;
+    biquad->z2 = in * biquad->a2 - biquad->b2 * out;
+    return out;
+}
+
+static void biquad_config_lowpass(Biquad *biquad, float Fc) {
+	float K = tanf(M_PI * Fc);
+	float Q = 0.707; // maximum sharpness (0.5 = maximum smoothness)
+	float norm = 1 / (1 + K / Q + K * K);
+	biquad->a0 = K * K * norm;
+	biquad->a1 = 2 * biquad->a0;
+	biquad->a2 = biquad->a0;
+	biquad->b1 = 2 * (K * K - 1) * norm;
+	biquad->b2 = (1 - K / Q + K * K) * norm;
+}
+
+// Starts the filter at value, so that it does not ramp up from 0
+static void biquad_reset(Biquad *biquad, float value) {
+	biquad->z1 = value * (1.0 - biquad->a0);
+	biquad->z2 = value * (biquad->a2 - biquad->b2);
+}
+
+static bool reg_write(data *d, Register reg, uint32_t val) {
+	VESC_IF->mutex_lock(d->bus_mutex);
+	bool res = regmap_write_reg(&d->regmap, reg, val);
+	VESC_IF->mutex_unlock(d->bus_mutex);
+	return res;
+}
+
+static bool fields_write(data *d, const int *f, const uint32_t *vals, int num) {
+	VESC_IF->mutex_lock(d->bus_mutex);
+	bool res = regmap_write_fields(&d->regmap, f, vals, num);
+	VESC_IF->mutex_unlock(d->bus_mutex);
+	return res;
+}
+
+static bool field_read(data *d, Field f, uint32_t *val) {
+	VESC_IF->mutex_lock(d->bus_mutex);
+	bool res = regmap_get(&d->regmap, f, false, val);
+	VESC_IF->mutex_unlock(d->bus_mutex);
+	return res;
+}
+
+// Conversion rates in SPS for each CRS value. 4 to 6 are not used.
+static int rate_to_crs(int rate) {
+	switch (rate) {
+	case 10: return 0;
+	case 20: return 1;
+	case 40: return 2;
+	case 80: return 3;
+	case 320: return 7;
+	default: return -1;
+	}
+}
+
+// Same configuration as nau-init in nau7802.lisp, but with the gain and the rate
+// as arguments.
+static bool nau_configure(data *d, int gains, int crs) {
+	bool ok = true;
+
+	VESC_IF->mutex_lock(d->bus_mutex);
+	regmap_invalidate(&d->regmap);
+	VESC_IF->mutex_unlock(d->bus_mutex);
+
+	// Reset
+	ok = ok && reg_write(d, R_PU_CTRL, FIELD_BIT(F_RR));
+	VESC_IF->sleep_ms(1);
+	ok = ok && reg_write(d, R_PU_CTRL, 0);
+	VESC_IF->sleep_ms(1);
+	ok = ok && reg_write(d, R_PU_CTRL, FIELD_BIT(F_PUD) | FIELD_BIT(F_PUA));
+
+	if (!ok) {
+		return false;
+	}
+
+	// Wait for power up
+	uint32_t pur = 0;
+	for (int i = 0;i < 100;i++) {
+		VESC_IF->sleep_ms(1);
+		if (field_read(d, F_PUR, &pur) && pur) {
+			break;
+		}
+	}
+
+	if (!pur) {
+		return false;
+	}
+
+	// PU_CTRL, CTRL1 and CTRL2 are next to each other, so this is one write.
+	// 3.0V LDO and DRDY active high.
+	static const int f_ctrl[] = {F_AVDDS, F_GAINS, F_VLDO, F_DRDY_SEL, F_CRP, F_CALMOD, F_CRS, F_CHS};
+	uint32_t v_ctrl[] = {1, gains, 5, 0, 0, 0, crs, 0};
+	ok = ok && fields_write(d, f_ctrl, v_ctrl, sizeof(f_ctrl) / sizeof(f_ctrl[0]));
+
+	// Disable chopper. Leaving the default causes noise for some reason.
+	ok = ok && reg_write(d, R_ADC_CONF, 3 << 4);
+
+	static const int f_cs[] = {F_CS};
+	static const uint32_t v_cs[] = {1};
+	ok = ok && fields_write(d, f_cs, v_cs, 1);
+	VESC_IF->sleep_ms(500);
+
+	// Clear calibration
+	ok = ok && reg_write(d, R_OCAL1, 0);
+
+	return ok;
+}
+
+static bool is_ready(data *d) {
+	if (d->drdy_gpio) {
+		return d->drdy_gpio->IDR & (1 << d->drdy_pin);
+	}
+
+	uint32_t cr;
+	return field_read(d, F_CR, &cr) && cr;
+}
+
+// The last num raw samples up to and including cnt - 1
+static float raw_average(data *d, uint32_t cnt, int num) {
+	int64_t sum = 0;
+	for (int i = 0;i < num;i++) {
+		sum += d->samples[(cnt - 1 - i) & SAMPLE_BUF_MASK];
+	}
+	return (float)sum / (float)num * ADC_SCALE;
+}
+
+static float raw_median(data *d, uint32_t cnt, int num) {
+	int32_t win[MAX_MEDIAN_WINDOW];
+
+	// Insertion sort, the window is small
+	for (int i = 0;i < num;i++) {
+		int32_t v = d->samples[(cnt - 1 - i) & SAMPLE_BUF_MASK];
+		int j = i;
+		while (j > 0 && win[j - 1] > v) {
+			win[j] = win[j - 1];
+			j--;
+		}
+		win[j] = v;
+	}
+
+	return (float)win[num / 2] * ADC_SCALE;
+}
+
+// Runs the new sample at index cnt through the pre-filter, the low-pass filter
+// and the calibration.
+static float pipeline_run(data *d, uint32_t cnt) {
+	pipeline_cfg *c = &d->cfg;
+	bool first = cnt == 0;
+
+	if (d->cfg_changed) {
+		VESC_IF->mutex_lock(d->cfg_mutex);
+		d->cfg_changed = false;
+		*c = d->cfg_new;
+		VESC_IF->mutex_unlock(d->cfg_mutex);
+
+		if (c->lp_hz > 0.0) {
+			biquad_config_lowpass(&d->lp, c->lp_hz / d->rate);
+		}
+		first = true;
+	}
+
+	// Windows are limited by the samples so far
+	int window = c->window;
+	if ((uint32_t)window > (cnt + 1)) {
+		window = cnt + 1;
+	}
+
+	float val;
+	switch (c->pre_filter) {
+	case PRE_FILTER_AVERAGE: val = raw_average(d, cnt + 1, window); break;
+	case PRE_FILTER_MEDIAN: val = raw_median(d, cnt + 1, window); break;
+	default: val = (float)d->samples[cnt & SAMPLE_BUF_MASK] * ADC_SCALE; break;
+	}
+
+	if (c->lp_hz > 0.0) {
+		if (first) {
+			biquad_reset(&d->lp, val);
+		}
+		val = biquad_process(&d->lp, val);
+	}
+
+	return (val - c->tare) * c->scale;
+}
+
+static void sample_thd(void *arg) {
+	data *d = (data*)arg;
+
+	// The configuration takes more than 500 ms, so it is done here while the
+	// context that called ext-nau-init is blocked.
+	bool ok = nau_configure(d, d->gains, d->crs);
+
+	// The context is blocked after ext-nau-init has returned, so unblocking it
+	// fails if the configuration fails before that, e.g. when the chip does not
+	// answer. Keep trying until it works.
+	lbm_value res = ok ? VESC_IF->lbm_enc_sym_true : VESC_IF->lbm_enc_sym_nil;
+	while (!VESC_IF->lbm_unblock_ctx(d->init_cid, res) && !VESC_IF->should_terminate()) {
+		VESC_IF->sleep_ms(1);
+	}
+	d->init_cid = -1;
+
+	if (!ok) {
+		while (!VESC_IF->should_terminate()) {
+			VESC_IF->sleep_ms(10);
+		}
+		return;
+	}
+
+	float period = 1.0 / d->rate;
+	uint32_t last_sample = VESC_IF->timer_time_now();
+
+	while (!VESC_IF->should_terminate()) {
+		// Sleep through most of the conversion and then poll for the last part
+		float left = 0.8 * period - VESC_IF->timer_seconds_elapsed_since(last_sample);
+		if (left > 0.0) {
+			VESC_IF->sleep_us((uint32_t)(left * 1.0e6));
+		}
+
+		while (!is_ready(d) && !VESC_IF->should_terminate()) {
+			if (VESC_IF->timer_seconds_elapsed_since(last_sample) > (2.0 * period + 0.1)) {
+				d->error_cnt++;
+				last_sample = VESC_IF->timer_time_now();
+			}
+			VESC_IF->sleep_us(200);
+		}
+
+		// The motor state is sampled as close as possible to the end of the
+		// conversion, before the I2C read.
+		bool capturing = d->capturing;
+		capture_point p;
+		if (capturing) {
+			p.time = VESC_IF->timer_seconds_elapsed_since(d->capture_start);
+			p.current = VESC_IF->mc_get_tot_current_filtered();
+			p.erpm = VESC_IF->mc_get_rpm();
+		}
+
+		// Reading the result clears CR and DRDY
+		uint32_t adc;
+		if (!field_read(d, F_ADC, &adc)) {
+			d->error_cnt++;
+			continue;
+		}
+
+		last_sample = VESC_IF->timer_time_now();
+
+		uint32_t cnt = d->sample_cnt;
+		d->samples[cnt & SAMPLE_BUF_MASK] = (int32_t)(adc << 8) >> 8;
+		d->filtered[cnt & SAMPLE_BUF_MASK] = pipeline_run(d, cnt);
+
+		if (capturing) {
+			p.raw = ((float)d->samples[cnt & SAMPLE_BUF_MASK] * ADC_SCALE - d->cfg.tare) * d->cfg.scale;
+			p.filtered = d->filtered[cnt & SAMPLE_BUF_MASK];
+
+			VESC_IF->mutex_lock(d->capture_mutex);
+			if (d->capturing && !rb_insert(&d->capture, &p)) {
+				d->capture_dropped++;
+			}
+			VESC_IF->mutex_unlock(d->capture_mutex);
+		}
+
+		// Publish the sample after it is written
+		__asm volatile ("" ::: "memory");
+		d->sample_cnt = cnt + 1;
+	}
+}
+
+static void nau_stop(data *d) {
+	if (d->thread) {
+		VESC_IF->request_terminate(d->thread);
+		d->thread = 0;
+	}
+}
+
+static bool get_pin(lbm_value *args, lbm_uint argn, unsigned int ind,
+		char *def, void **gpio, uint32_t *pin) {
+	lbm_uint sym;
+	if (argn > ind) {
+		if (!VESC_IF->lbm_is_symbol(args[ind])) {
+			return false;
+		}
+		sym = VESC_IF->lbm_dec_sym(args[ind]);
+	} else if (!VESC_IF->lbm_get_symbol_by_name(def, &sym)) {
+		return false;
+	}
+
+	return VESC_IF->lbm_symbol_to_io(sym, gpio, pin);
+}
+
+// (ext-nau-init optRate optGain optPinSda optPinScl optPinDrdy), configures the
+// NAU7802 and starts sampling. Returns nil if the NAU7802 does not respond.
+static lbm_value ext_init(lbm_value *args, lbm_uint argn) {
+	if (argn > 5) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	for (unsigned int i = 0;i < argn && i < 2;i++) {
+		if (!VESC_IF->lbm_is_number(args[i])) {
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+	}
+
+	data *d = (data*)ARG;
+	nau_stop(d);
+
+	int rate = argn >= 1 ? VESC_IF->lbm_dec_as_i32(args[0]) : 80;
+	int crs = rate_to_crs(rate);
+	if (crs < 0) {
+		VESC_IF->lbm_set_error_reason("Invalid Rate");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	int gain = argn >= 2 ? VESC_IF->lbm_dec_as_i32(args[1]) : 128;
+	int gains = -1;
+	for (int i = 0;i < 8;i++) {
+		if (gain == (1 << i)) {
+			gains = i;
+		}
+	}
+	if (gains < 0) {
+		VESC_IF->lbm_set_error_reason("Invalid Gain");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	void *sda_gpio, *scl_gpio;
+	uint32_t sda_pin, scl_pin;
+	if (!get_pin(args, argn, 2, "pin-rx", &sda_gpio, &sda_pin) ||
+			!get_pin(args, argn, 3, "pin-tx", &scl_gpio, &scl_pin)) {
+		VESC_IF->lbm_set_error_reason("Invalid Pin");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	d->drdy_gpio = 0;
+	if (argn >= 5) {
+		void *drdy_gpio;
+		if (!get_pin(args, argn, 4, 0, &drdy_gpio, &d->drdy_pin)) {
+			VESC_IF->lbm_set_error_reason("Invalid Pin");
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+		VESC_IF->set_pad_mode(drdy_gpio, d->drdy_pin, PAL_STM32_MODE_INPUT | PAL_STM32_PUDR_PULLDOWN);
+		d->drdy_gpio = (stm32_gpio_t*)drdy_gpio;
+	}
+
+	i2c_bb_init(&d->i2c, sda_gpio, sda_pin, scl_gpio, scl_pin, NAU_I2C_RATE);
+
+	// Apply the filter for the new rate
+	VESC_IF->mutex_lock(d->cfg_mutex);
+	d->cfg_changed = true;
+	VESC_IF->mutex_unlock(d->cfg_mutex);
+
+	d->read_raw = 0;
+	d->read_filtered = 0;
+	d->rate = rate;
+	d->gains = gains;
+	d->crs = crs;
+	d->sample_cnt = 0;
+	d->error_cnt = 0;
+	d->init_cid = VESC_IF->lbm_get_current_cid();
+	d->thread = VESC_IF->spawn(sample_thd, 512, "NAU7802", d);
+
+	if (!d->thread) {
+		return VESC_IF->lbm_enc_sym_merror;
+	}
+
+	VESC_IF->lbm_block_ctx_from_extension();
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-nau-stop)
+static lbm_value ext_stop(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+	nau_stop((data*)ARG);
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-nau-latest), returns the latest sample or nil if there are no samples yet
+static lbm_value ext_latest(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+
+	data *d = (data*)ARG;
+	uint32_t cnt = d->sample_cnt;
+	if (cnt == 0) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	return VESC_IF->lbm_enc_float((float)d->samples[(cnt - 1) & SAMPLE_BUF_MASK] * ADC_SCALE);
+}
+
+// (ext-nau-average samples), returns the average of the latest samples
+static lbm_value ext_average(lbm_value *args, lbm_uint argn) {
+	if (argn != 1 || !VESC_IF->lbm_is_number(args[0])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	uint32_t cnt = d->sample_cnt;
+	uint32_t num = VESC_IF->lbm_dec_as_u32(args[0]);
+
+	// Leave some margin to the sample that is written next
+	if (num > (SAMPLE_BUF_LEN - 8)) {
+		num = SAMPLE_BUF_LEN - 8;
+	}
+	if (num > cnt) {
+		num = cnt;
+	}
+	if (num == 0) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	return VESC_IF->lbm_enc_float(raw_average(d, cnt, num));
+}
+
+// (ext-nau-sample-cnt), returns the number of samples since ext-nau-init and the
+// number of failed reads
+static lbm_value ext_sample_cnt(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+
+	data *d = (data*)ARG;
+	lbm_value errors = VESC_IF->lbm_enc_u(d->error_cnt);
+	lbm_value res = VESC_IF->lbm_cons(errors, VESC_IF->lbm_enc_sym_nil);
+	return VESC_IF->lbm_cons(VESC_IF->lbm_enc_u(d->sample_cnt), res);
+}
+
+// (ext-nau-value), returns the latest filtered and calibrated sample, or nil if
+// there are no samples yet
+static lbm_value ext_value(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+
+	data *d = (data*)ARG;
+	uint32_t cnt = d->sample_cnt;
+	if (cnt == 0) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	return VESC_IF->lbm_enc_float(d->filtered[(cnt - 1) & SAMPLE_BUF_MASK]);
+}
+
+// (ext-nau-get-new optFiltered), returns the samples since the previous call as a
+// list, oldest first. The raw and the filtered samples are read separately.
+static lbm_value ext_get_new(lbm_value *args, lbm_uint argn) {
+	data *d = (data*)ARG;
+	bool filtered = argn >= 1 && !VESC_IF->lbm_is_symbol_nil(args[0]) &&
+			!(VESC_IF->lbm_is_number(args[0]) && VESC_IF->lbm_dec_as_i32(args[0]) == 0);
+
+	uint32_t cnt = d->sample_cnt;
+	uint32_t *read = filtered ? &d->read_filtered : &d->read_raw;
+
+	// Samples that have been overwritten are skipped
+	if ((cnt - *read) > (SAMPLE_BUF_LEN - 8)) {
+		*read = cnt - (SAMPLE_BUF_LEN - 8);
+	}
+
+	lbm_value res = VESC_IF->lbm_enc_sym_nil;
+	for (uint32_t i = cnt;i != *read;i--) {
+		uint32_t ind = (i - 1) & SAMPLE_BUF_MASK;
+		float v = filtered ? d->filtered[ind] : (float)d->samples[ind] * ADC_SCALE;
+
+		lbm_value val = VESC_IF->lbm_enc_float(v);
+		if (val == VESC_IF->lbm_enc_sym_merror) {
+			return val;
+		}
+
+		res = VESC_IF->lbm_cons(val, res);
+		if (res == VESC_IF->lbm_enc_sym_merror) {
+			return res;
+		}
+	}
+
+	*read = cnt;
+	return res;
+}
+
+static void update_cfg(data *d, pipeline_cfg *cfg) {
+	VESC_IF->mutex_lock(d->cfg_mutex);
+	d->cfg_new = *cfg;
+	d->cfg_changed = true;
+	VESC_IF->mutex_unlock(d->cfg_mutex);
+}
+
+// (ext-nau-filter mode optWindow optLpHz), mode is 0 for no pre-filter, 1 for a
+// moving average and 2 for a median over window samples. optLpHz is the cutoff of
+// the low-pass filter after that, 0 to disable it.
+static lbm_value ext_filter(lbm_value *args, lbm_uint argn) {
+	if (argn < 1 || argn > 3) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	for (unsigned int i = 0;i < argn;i++) {
+		if (!VESC_IF->lbm_is_number(args[i])) {
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+	}
+
+	data *d = (data*)ARG;
+	pipeline_cfg cfg = d->cfg_new;
+
+	int mode = VESC_IF->lbm_dec_as_i32(args[0]);
+	int window = argn >= 2 ? VESC_IF->lbm_dec_as_i32(args[1]) : 1;
+	float lp_hz = argn >= 3 ? VESC_IF->lbm_dec_as_float(args[2]) : 0.0;
+
+	if (mode < PRE_FILTER_NONE || mode > PRE_FILTER_MEDIAN) {
+		VESC_IF->lbm_set_error_reason("Invalid Mode");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	int max_window = mode == PRE_FILTER_MEDIAN ? MAX_MEDIAN_WINDOW : MAX_AVG_WINDOW;
+	if (window < 1) {
+		window = 1;
+	} else if (window > max_window) {
+		window = max_window;
+	}
+
+	// The cutoff has to be below half the sample rate
+	if (lp_hz < 0.0 || lp_hz >= (d->rate / 2.0)) {
+		VESC_IF->lbm_set_error_reason("Invalid Cutoff");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	cfg.pre_filter = mode;
+	cfg.window = window;
+	cfg.lp_hz = lp_hz;
+	update_cfg(d, &cfg);
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// Average of the latest raw samples for the calibration
+static bool cal_average(data *d, lbm_value *args, lbm_uint argn, unsigned int ind, float *avg) {
+	int num = 32;
+	if (argn > ind) {
+		if (!VESC_IF->lbm_is_number(args[ind])) {
+			return false;
+		}
+		num = VESC_IF->lbm_dec_as_i32(args[ind]);
+	}
+
+	uint32_t cnt = d->sample_cnt;
+	if (num > (SAMPLE_BUF_LEN - 8)) {
+		num = SAMPLE_BUF_LEN - 8;
+	}
+	if ((uint32_t)num > cnt) {
+		num = cnt;
+	}
+	if (num <= 0) {
+		return false;
+	}
+
+	*avg = raw_average(d, cnt, num);
+	return true;
+}
+
+// (ext-nau-tare optSamples), sets the zero point to the average of the latest
+// samples and returns it. Run without load.
+static lbm_value ext_tare(lbm_value *args, lbm_uint argn) {
+	data *d = (data*)ARG;
+	pipeline_cfg cfg = d->cfg_new;
+
+	if (!cal_average(d, args, argn, 0, &cfg.tare)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	update_cfg(d, &cfg);
+	return VESC_IF->lbm_enc_float(cfg.tare);
+}
+
+// (ext-nau-cal-weight weight optSamples), calculates the scale from the latest
+// samples with a known weight on the load cell and returns it. Run ext-nau-tare
+// first.
+static lbm_value ext_cal_weight(lbm_value *args, lbm_uint argn) {
+	if (argn < 1 || !VESC_IF->lbm_is_number(args[0])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	pipeline_cfg cfg = d->cfg_new;
+
+	float avg;
+	if (!cal_average(d, args, argn, 1, &avg)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	float diff = avg - cfg.tare;
+	if (fabsf(diff) < 1.0e-9) {
+		VESC_IF->lbm_set_error_reason("No Load");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	cfg.scale = VESC_IF->lbm_dec_as_float(args[0]) / diff;
+	update_cfg(d, &cfg);
+	return VESC_IF->lbm_enc_float(cfg.scale);
+}
+
+// (ext-nau-set-cal tare scale)
+static lbm_value ext_set_cal(lbm_value *args, lbm_uint argn) {
+	if (argn != 2 || !VESC_IF->lbm_is_number(args[0]) || !VESC_IF->lbm_is_number(args[1])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	pipeline_cfg cfg = d->cfg_new;
+	cfg.tare = VESC_IF->lbm_dec_as_float(args[0]);
+	cfg.scale = VESC_IF->lbm_dec_as_float(args[1]);
+	update_cfg(d, &cfg);
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-nau-get-cal), returns (tare scale)
+static lbm_value ext_get_cal(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+
+	data *d = (data*)ARG;
+	lbm_value tare = VESC_IF->lbm_enc_float(d->cfg_new.tare);
+	lbm_value scale = VESC_IF->lbm_enc_float(d->cfg_new.scale);
+	if (tare == VESC_IF->lbm_enc_sym_merror || scale == VESC_IF->lbm_enc_sym_merror) {
+		return VESC_IF->lbm_enc_sym_merror;
+	}
+
+	lbm_value res = VESC_IF->lbm_cons(scale, VESC_IF->lbm_enc_sym_nil);
+	if (res == VESC_IF->lbm_enc_sym_merror) {
+		return res;
+	}
+	return VESC_IF->lbm_cons(tare, res);
+}
+
+static bool get_cal_addr(lbm_value *args, lbm_uint argn, int *addr) {
+	*addr = CAL_DEFAULT_ADDR;
+	if (argn >= 1) {
+		if (!VESC_IF->lbm_is_number(args[0])) {
+			return false;
+		}
+		*addr = VESC_IF->lbm_dec_as_i32(args[0]);
+	}
+	return *addr >= 0;
+}
+
+// (ext-nau-cal-store optAddr), stores the calibration in the EEPROM at optAddr
+// to optAddr + 2.
+static lbm_value ext_cal_store(lbm_value *args, lbm_uint argn) {
+	int addr;
+	if (!get_cal_addr(args, argn, &addr)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	eeprom_var magic, tare, scale;
+	magic.as_u32 = CAL_MAGIC;
+	tare.as_float = d->cfg_new.tare;
+	scale.as_float = d->cfg_new.scale;
+
+	bool ok = VESC_IF->store_eeprom_var(&tare, addr + 1) &&
+			VESC_IF->store_eeprom_var(&scale, addr + 2) &&
+			VESC_IF->store_eeprom_var(&magic, addr);
+
+	return ok ? VESC_IF->lbm_enc_sym_true : VESC_IF->lbm_enc_sym_nil;
+}
+
+// (ext-nau-cal-load optAddr), loads the calibration from the EEPROM. Returns nil
+// if no calibration has been stored there.
+static lbm_value ext_cal_load(lbm_value *args, lbm_uint argn) {
+	int addr;
+	if (!get_cal_addr(args, argn, &addr)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	eeprom_var magic, tare, scale;
+	if (!VESC_IF->read_eeprom_var(&magic, addr) || magic.as_u32 != CAL_MAGIC ||
+			!VESC_IF->read_eeprom_var(&tare, addr + 1) ||
+			!VESC_IF->read_eeprom_var(&scale, addr + 2)) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	pipeline_cfg cfg = d->cfg_new;
+	cfg.tare = tare.as_float;
+	cfg.scale = scale.as_float;
+	update_cfg(d, &cfg);
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+static void capture_free(data *d) {
+	VESC_IF->mutex_lock(d->capture_mutex);
+	d->capturing = false;
+	if (d->capture.data) {
+		rb_free(&d->capture);
+		d->capture.data = 0;
+	}
+	VESC_IF->mutex_unlock(d->capture_mutex);
+}
+
+// (ext-nau-capture-start optLen), starts a capture of up to optLen points. Each
+// conversion is stored together with the motor current and ERPM at the time the
+// conversion completed.
+static lbm_value ext_capture_start(lbm_value *args, lbm_uint argn) {
+	if (argn > 1 || (argn == 1 && !VESC_IF->lbm_is_number(args[0]))) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	int len = argn == 1 ? VESC_IF->lbm_dec_as_i32(args[0]) : CAPTURE_DEFAULT_LEN;
+	if (len < 1) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	capture_free(d);
+
+	VESC_IF->mutex_lock(d->capture_mutex);
+	rb_init_alloc(&d->capture, sizeof(capture_point), len);
+	if (!d->capture.data) {
+		VESC_IF->free(d->capture.mutex);
+		VESC_IF->mutex_unlock(d->capture_mutex);
+		return VESC_IF->lbm_enc_sym_merror;
+	}
+
+	d->capture_dropped = 0;
+	d->capture_start = VESC_IF->timer_time_now();
+	d->capturing = true;
+	VESC_IF->mutex_unlock(d->capture_mutex);
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-nau-capture-stop), stops capturing. The points that have not been read yet
+// can still be read.
+static lbm_value ext_capture_stop(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+
+	data *d = (data*)ARG;
+	d->capturing = false;
+	return VESC_IF->lbm_enc_u(d->capture_dropped);
+}
+
+static void append_f32(uint8_t *buffer, float number, int32_t *index) {
+	uint32_t res;
+	memcpy(&res, &number, sizeof(res));
+	buffer[(*index)++] = res >> 24;
+	buffer[(*index)++] = res >> 16;
+	buffer[(*index)++] = res >> 8;
+	buffer[(*index)++] = res;
+}
+
+// (ext-nau-capture-get optMax), returns up to optMax captured points as a byte
+// array, or nil if there are none. Every point has 5 big endian floats: time,
+// raw, filtered, current and erpm.
+static lbm_value ext_capture_get(lbm_value *args, lbm_uint argn) {
+	if (argn > 1 || (argn == 1 && !VESC_IF->lbm_is_number(args[0]))) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	if (!d->capture.data) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	int max = argn == 1 ? VESC_IF->lbm_dec_as_i32(args[0]) : CAPTURE_MAX_GET;
+	if (max > CAPTURE_MAX_GET) {
+		max = CAPTURE_MAX_GET;
+	}
+
+	int num = rb_get_item_count(&d->capture);
+	if (num > max) {
+		num = max;
+	}
+	if (num <= 0) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	lbm_value res;
+	if (!VESC_IF->lbm_create_byte_array(&res, num * CAPTURE_POINT_LEN)) {
+		return VESC_IF->lbm_enc_sym_merror;
+	}
+
+	uint8_t *buffer = (uint8_t*)((lbm_array_header_t*)VESC_IF->lbm_car(res))->data;
+	int32_t ind = 0;
+	capture_point p;
+	for (int i = 0;i < num && rb_pop(&d->capture, &p);i++) {
+		append_f32(buffer, p.time, &ind);
+		append_f32(buffer, p.raw, &ind);
+		append_f32(buffer, p.filtered, &ind);
+		append_f32(buffer, p.current, &ind);
+		append_f32(buffer, p.erpm, &ind);
+	}
+
+	return res;
+}
+
+// Field from its name as a string, returns -1 if there is no such field
+static int get_field(data *d, lbm_value arg) {
+	char *name = VESC_IF->lbm_dec_str(arg);
+	if (!name) {
+		return -1;
+	}
+	return regmap_find_field(&d->regmap, name);
+}
+
+// (ext-nau-reg-get field optCached), returns the value of field, which is a
+// string with the name from nau7802.lisp. When optCached is true the last value
+// that was read or written is returned without any I2C traffic.
+static lbm_value ext_reg_get(lbm_value *args, lbm_uint argn) {
+	if (argn != 1 && argn != 2) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	int f = get_field(d, args[0]);
+	if (f < 0) {
+		VESC_IF->lbm_set_error_reason("Invalid Field");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	bool cached = argn == 2 && !VESC_IF->lbm_is_symbol_nil(args[1]);
+
+	uint32_t val;
+	VESC_IF->mutex_lock(d->bus_mutex);
+	bool ok = regmap_get(&d->regmap, f, cached, &val);
+	VESC_IF->mutex_unlock(d->bus_mutex);
+
+	return ok ? VESC_IF->lbm_enc_u32(val) : VESC_IF->lbm_enc_sym_nil;
+}
+
+// (ext-nau-reg-set field1 val1 optField2 optVal2 ...), sets up to 8 fields.
+// Each register is only written once, and registers that are next to each other
+// are written in the same transaction. Returns nil on I2C errors.
+static lbm_value ext_reg_set(lbm_value *args, lbm_uint argn) {
+	if (argn < 2 || (argn % 2) != 0 || argn > 2 * REG_SET_MAX) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	int f[REG_SET_MAX];
+	uint32_t vals[REG_SET_MAX];
+	int num = argn / 2;
+
+	for (int i = 0;i < num;i++) {
+		f[i] = get_field(d, args[2 * i]);
+		if (f[i] < 0) {
+			VESC_IF->lbm_set_error_reason("Invalid Field");
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+
+		if (!VESC_IF->lbm_is_number(args[2 * i + 1])) {
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+		vals[i] = VESC_IF->lbm_dec_as_u32(args[2 * i + 1]);
+	}
+
+	return fields_write(d, f, vals, num) ? VESC_IF->lbm_enc_sym_true : VESC_IF->lbm_enc_sym_nil;
+}
+
+// (ext-nau-reg-refresh), reads all registers in one burst so that the cached
+// values of ext-nau-reg-get are up to date
+static lbm_value ext_reg_refresh(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+
+	data *d = (data*)ARG;
+	VESC_IF->mutex_lock(d->bus_mutex);
+	bool ok = regmap_read(&d->regmap, 0, R_NUM - 1);
+	VESC_IF->mutex_unlock(d->bus_mutex);
+
+	return ok ? VESC_IF->lbm_enc_sym_true : VESC_IF->lbm_enc_sym_nil;
+}
+
+static void stop(void *arg) {
+	data *d = (data*)arg;
+	nau_stop(d);
+	capture_free(d);
+	regmap_free(&d->regmap);
+	VESC_IF->free(d->bus_mutex);
+	VESC_IF->free(d->capture_mutex);
+	VESC_IF->free(d->cfg_mutex);
+	VESC_IF->free(d);
+}
+
+INIT_FUN(lib_info *info) {
+	INIT_START
+
+	data *d = VESC_IF->malloc(sizeof(data));
+	if (!d) {
+		return false;
+	}
+
+	if (!regmap_init(&d->regmap, &d->i2c, NAU_I2C_ADDR, regs, R_NUM, fields, F_NUM)) {
+		VESC_IF->free(d);
+		return false;
+	}
+	d->bus_mutex = VESC_IF->mutex_create();
+
+	d->thread = 0;
+	d->drdy_gpio = 0;
+	d->rate = 80.0;
+	d->init_cid = -1;
+	d->read_raw = 0;
+	d->read_filtered = 0;
+
+	// No filtering and no calibration by default, so that the filtered samples
+	// are the same as the raw samples.
+	memset(&d->cfg, 0, sizeof(d->cfg));
+	d->cfg.pre_filter = PRE_FILTER_NONE;
+	d->cfg.window = 1;
+	d->cfg.scale = 1.0;
+	d->cfg_new = d->cfg;
+	d->cfg_changed = false;
+	d->cfg_mutex = VESC_IF->mutex_create();
+
+	d->capture.data = 0;
+	d->capturing = false;
+	d->capture_dropped = 0;
+	d->capture_mutex = VESC_IF->mutex_create();
+	d->sample_cnt = 0;
+	d->error_cnt = 0;
+
+	VESC_IF->lbm_add_extension("ext-nau-init", ext_init);
+	VESC_IF->lbm_add_extension("ext-nau-stop", ext_stop);
+	VESC_IF->lbm_add_extension("ext-nau-latest", ext_latest);
+	VESC_IF->lbm_add_extension("ext-nau-average", ext_average);
+	VESC_IF->lbm_add_extension("ext-nau-sample-cnt", ext_sample_cnt);
+	VESC_IF->lbm_add_extension("ext-nau-value", ext_value);
+	VESC_IF->lbm_add_extension("ext-nau-get-new", ext_get_new);
+	VESC_IF->lbm_add_extension("ext-nau-filter", ext_filter);
+	VESC_IF->lbm_add_extension("ext-nau-tare", ext_tare);
+	VESC_IF->lbm_add_extension("ext-nau-cal-weight", ext_cal_weight);
+	VESC_IF->lbm_add_extension("ext-nau-set-cal", ext_set_cal);
+	VESC_IF->lbm_add_extension("ext-nau-get-cal", ext_get_cal);
+	VESC_IF->lbm_add_extension("ext-nau-cal-store", ext_cal_store);
+	VESC_IF->lbm_add_extension("ext-nau-cal-load", ext_cal_load);
+	VESC_IF->lbm_add_extension("ext-nau-capture-start", ext_capture_start);
+	VESC_IF->lbm_add_extension("ext-nau-capture-stop", ext_capture_stop);
+	VESC_IF->lbm_add_extension("ext-nau-capture-get", ext_capture_get);
+	VESC_IF->lbm_add_extension("ext-nau-reg-get", ext_reg_get);
+	VESC_IF->lbm_add_extension("ext-nau-reg-set", ext_reg_set);
+	VESC_IF->lbm_add_extension("ext-nau-reg-refresh", ext_reg_refresh);
+
+	info->stop_fun = stop;
+	info->arg = d;
+
+	return true;
+}
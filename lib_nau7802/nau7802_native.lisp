@@ -0,0 +1 @@
+(import "nau7802/nau7802.bin" 'nau7802)
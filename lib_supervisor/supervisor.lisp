@@ -0,0 +1 @@
+(import "supervisor/supervisor.bin" 'supervisor)
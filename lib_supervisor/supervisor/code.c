@@ -0,0 +1,295 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vesc_c_if.h"
+#include "supervisor.h"
+
+#include <math.h>
+#include <string.h>
+
+HEADER
+
+// Names of the sources as LispBM symbols. The order must match SUPERVISOR_SRC.
+static const char source_names[SUPERVISOR_SRC_NUM][10] = {
+	"vin",
+	"temp-fet",
+	"temp-mot",
+	"fault",
+};
+
+// Context that waits for any monitor
+#define WAIT_ANY			SUPERVISOR_MAX_MONITORS
+
+typedef struct {
+	lbm_uint syms[SUPERVISOR_SRC_NUM];
+	supervisor_t sup;
+
+	// One bit per monitor that has fired and has not been passed to a context
+	// yet. Both fields are protected by the supervisor mutex.
+	uint32_t pending;
+	int wait_cid[SUPERVISOR_MAX_MONITORS + 1];
+} data;
+
+// Called from the supervisor thread. The id is kept until it has been passed
+// to a context in ext-supervisor-wait.
+static void sup_cb(int id, float value, void *arg) {
+	(void)value;
+	data *d = (data*)arg;
+
+	VESC_IF->mutex_lock(d->sup.mutex);
+	d->pending |= 1 << id;
+	VESC_IF->mutex_unlock(d->sup.mutex);
+}
+
+// Passes id to the context that waits for it, or to the one that waits for any
+// monitor. Returns true if a context got it. Must be called with the mutex locked.
+static bool deliver(data *d, int id) {
+	int slot = d->wait_cid[id] >= 0 ? id : WAIT_ANY;
+	int cid = d->wait_cid[slot];
+
+	if (cid < 0 || !VESC_IF->lbm_unblock_ctx(cid, VESC_IF->lbm_enc_i(id))) {
+		return false;
+	}
+
+	d->wait_cid[slot] = -1;
+	d->pending &= ~(1 << id);
+	return true;
+}
+
+// Called from the supervisor thread after every round. A waiting context is
+// blocked after ext-supervisor-wait has returned, so unblocking it fails if this
+// runs in between. The id and the cid are kept for the next round in that case.
+static void sup_tick_cb(void *arg) {
+	data *d = (data*)arg;
+
+	VESC_IF->mutex_lock(d->sup.mutex);
+	for (int id = 0;id < SUPERVISOR_MAX_MONITORS;id++) {
+		if (d->pending & (1 << id)) {
+			deliver(d, id);
+		}
+	}
+	VESC_IF->mutex_unlock(d->sup.mutex);
+}
+
+// (ext-supervisor-add source threshold optBelow optHysteresis), where source is
+// one of vin, temp-fet, temp-mot and fault. Returns the id of the monitor.
+static lbm_value ext_add(lbm_value *args, lbm_uint argn) {
+	if (argn < 2 || argn > 4 || !VESC_IF->lbm_is_symbol(args[0]) ||
+			!VESC_IF->lbm_is_number(args[1])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+
+	lbm_uint sym = VESC_IF->lbm_dec_sym(args[0]);
+	int source = -1;
+	for (int i = 0;i < SUPERVISOR_SRC_NUM;i++) {
+		if (d->syms[i] == sym) {
+			source = i;
+			break;
+		}
+	}
+
+	if (source < 0) {
+		VESC_IF->lbm_set_error_reason("Unknown Source");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	bool below = false;
+	if (argn >= 3) {
+		below = VESC_IF->lbm_is_number(args[2]) ? VESC_IF->lbm_dec_as_i32(args[2]) != 0 :
+				!VESC_IF->lbm_is_symbol_nil(args[2]);
+	}
+
+	float hyst = 0.0;
+	if (argn >= 4) {
+		if (!VESC_IF->lbm_is_number(args[3])) {
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+		hyst = fabsf(VESC_IF->lbm_dec_as_float(args[3]));
+	}
+
+	int id = supervisor_add(&d->sup, source, below,
+			VESC_IF->lbm_dec_as_float(args[1]), hyst, sup_cb, d);
+	if (id < 0) {
+		VESC_IF->lbm_set_error_reason("Too Many Monitors");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	if (!supervisor_start(&d->sup)) {
+		supervisor_remove(&d->sup, id);
+		VESC_IF->lbm_set_error_reason("Could not start thread");
+		return VESC_IF->lbm_enc_sym_merror;
+	}
+
+	return VESC_IF->lbm_enc_i(id);
+}
+
+static bool dec_id(lbm_value *args, lbm_uint argn, int *id) {
+	if (argn != 1 || !VESC_IF->lbm_is_number(args[0])) {
+		return false;
+	}
+
+	*id = VESC_IF->lbm_dec_as_i32(args[0]);
+	return *id >= 0 && *id < SUPERVISOR_MAX_MONITORS;
+}
+
+// (ext-supervisor-remove id)
+static lbm_value ext_remove(lbm_value *args, lbm_uint argn) {
+	int id;
+	if (!dec_id(args, argn, &id)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	if (!supervisor_remove(&d->sup, id)) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	// A context that waits for this monitor would never wake up otherwise
+	VESC_IF->mutex_lock(d->sup.mutex);
+	d->pending &= ~(1 << id);
+	int cid = d->wait_cid[id];
+	d->wait_cid[id] = -1;
+	VESC_IF->mutex_unlock(d->sup.mutex);
+
+	if (cid >= 0) {
+		VESC_IF->lbm_unblock_ctx(cid, VESC_IF->lbm_enc_sym_nil);
+	}
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-supervisor-rearm id), makes a monitor that has fired fire again if the
+// value still is past the threshold
+static lbm_value ext_rearm(lbm_value *args, lbm_uint argn) {
+	int id;
+	if (!dec_id(args, argn, &id)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	return supervisor_rearm(&d->sup, id) ? VESC_IF->lbm_enc_sym_true : VESC_IF->lbm_enc_sym_nil;
+}
+
+// (ext-supervisor-rate hz)
+static lbm_value ext_rate(lbm_value *args, lbm_uint argn) {
+	if (argn != 1 || !VESC_IF->lbm_is_number(args[0])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	float rate = VESC_IF->lbm_dec_as_float(args[0]);
+	if (rate <= 0.0 || rate > 1000.0) {
+		VESC_IF->lbm_set_error_reason("Invalid Rate");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	supervisor_set_rate(&d->sup, rate);
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-supervisor-wait optId), blocks until the monitor with optId fires, or any
+// monitor that no other context waits for without optId, and returns its id.
+// Only one context can wait for each id at a time.
+static lbm_value ext_wait(lbm_value *args, lbm_uint argn) {
+	int slot = WAIT_ANY;
+	if (argn > 0 && !dec_id(args, argn, &slot)) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	lbm_value res = VESC_IF->lbm_enc_sym_true;
+
+	VESC_IF->mutex_lock(d->sup.mutex);
+	uint32_t mask = d->pending & (1 << slot);
+	if (slot == WAIT_ANY) {
+		// Leave the monitors that other contexts wait for to them
+		mask = d->pending;
+		for (int i = 0;i < SUPERVISOR_MAX_MONITORS;i++) {
+			if (d->wait_cid[i] >= 0) {
+				mask &= ~(1 << i);
+			}
+		}
+	}
+
+	if (d->wait_cid[slot] >= 0) {
+		VESC_IF->lbm_set_error_reason("Already Waiting");
+		res = VESC_IF->lbm_enc_sym_eerror;
+	} else if (mask) {
+		int id = 0;
+		while (!(mask & (1 << id))) {
+			id++;
+		}
+		d->pending &= ~(1 << id);
+		res = VESC_IF->lbm_enc_i(id);
+	} else {
+		d->wait_cid[slot] = VESC_IF->lbm_get_current_cid();
+		VESC_IF->lbm_block_ctx_from_extension();
+	}
+	VESC_IF->mutex_unlock(d->sup.mutex);
+
+	return res;
+}
+
+static void stop(void *arg) {
+	data *d = (data*)arg;
+
+	supervisor_stop(&d->sup);
+	for (int i = 0;i <= SUPERVISOR_MAX_MONITORS;i++) {
+		if (d->wait_cid[i] >= 0) {
+			VESC_IF->lbm_unblock_ctx(d->wait_cid[i], VESC_IF->lbm_enc_sym_nil);
+		}
+	}
+	supervisor_free(&d->sup);
+
+	VESC_IF->free(d);
+}
+
+INIT_FUN(lib_info *info) {
+	INIT_START
+
+	data *d = VESC_IF->malloc(sizeof(data));
+	if (!d) {
+		return false;
+	}
+
+	for (int i = 0;i < SUPERVISOR_SRC_NUM;i++) {
+		VESC_IF->lbm_add_symbol_const((char*)source_names[i], &d->syms[i]);
+	}
+
+	// The thread is started with the first monitor
+	supervisor_init(&d->sup, 100.0);
+	supervisor_set_tick_cb(&d->sup, sup_tick_cb, d);
+	d->pending = 0;
+	for (int i = 0;i <= SUPERVISOR_MAX_MONITORS;i++) {
+		d->wait_cid[i] = -1;
+	}
+
+	VESC_IF->lbm_add_extension("ext-supervisor-add", ext_add);
+	VESC_IF->lbm_add_extension("ext-supervisor-remove", ext_remove);
+	VESC_IF->lbm_add_extension("ext-supervisor-rearm", ext_rearm);
+	VESC_IF->lbm_add_extension("ext-supervisor-rate", ext_rate);
+	VESC_IF->lbm_add_extension("ext-supervisor-wait", ext_wait);
+
+	info->stop_fun = stop;
+	info->arg = d;
+
+	return true;
+}
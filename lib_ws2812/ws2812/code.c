@@ -19,89 +19,132 @@
  
 #include "st_types.h"
 #include "vesc_c_if.h"
+#include "ws2812_encode.h"
 
 #include <math.h>
+#include <string.h>
 
 HEADER
 
 // Settings
-#define WS2812_CLK_HZ		800000
-#define TIM_PERIOD			(((168000000 / 2 / WS2812_CLK_HZ) - 1))
-#define WS2812_ZERO			(TIM_PERIOD * 0.2)
-#define WS2812_ONE			(TIM_PERIOD * 0.8)
 #define BITBUFFER_PAD		50
 
+// Animations
+#define ANIM_RATE_DEFAULT	50
+
+typedef enum {
+	ANIM_OFF = 0,
+	ANIM_SOLID,
+	ANIM_GRADIENT,
+	ANIM_CHASE,
+	ANIM_BREATHING,
+	ANIM_BATTERY,
+	ANIM_SPEED
+} ANIM_TYPE;
+
+typedef struct {
+	ANIM_TYPE type;
+	uint32_t color1;
+	uint32_t color2;
+	float speed;
+	float param;
+} anim_params;
+
+// Number of LEDs encoded into each half of the DMA window in streaming mode, which
+// gives a window of 768 bytes for RGB and 1 KB for RGBW. One half lasts
+// STREAM_LEDS * bits * 1.25 us (240 us with 24 bits), which is the deadline for
+// the refill thread.
+#define STREAM_LEDS			8
+
+// The refill thread sleeps until this long before the next half is due and polls
+// the DMA flags for the rest, as sleeps can be up to two system ticks late
+#define STREAM_SLEEP_MARGIN_US	200
+
+// Time that the output is held low after an aborted frame, so that the LEDs latch
+// and the next frame starts from the first LED again
+#define STREAM_RESET_US		300
+
+// An aborted frame is sent again after a delay that doubles for every attempt,
+// up to this many ms
+#define STREAM_MAX_BACKOFF_MS	64
+
 typedef struct {
 	bool is_tim4;
 	bool is_ch2;
-	int bits;
+	bool stream;
+	ws2812_enc enc;
 	int num_leds;
 	int ledbuf_len;
 	int bitbuf_len;
 	uint16_t *bitbuffer;
 	uint32_t *RGBdata;
 	uint32_t brightness;
+	bool gamma;
+
+	TIM_TypeDef *tim;
+	DMA_Stream_TypeDef *dma_stream;
+
+	// Streaming state
+	uint32_t flag_ht;
+	uint32_t flag_tc;
+	int stream_led;
+	bool half_is_pad[2];
+	volatile bool frame_pending;
+	lib_thread stream_thd;
+
+	// Animation state. The parameters are written by ext-ws2812-anim and copied
+	// by the animation thread under anim_mutex.
+	lib_mutex anim_mutex;
+	anim_params anim;
+	volatile int anim_rate;
+	float anim_start;
+	lib_thread anim_thd;
 } ws_cfg;
 
-static uint32_t rgb_to_local(ws_cfg *cfg, uint32_t color) {
-	uint32_t w = (color >> 24) & 0xFF;
-	uint32_t r = (color >> 16) & 0xFF;
-	uint32_t g = (color >> 8) & 0xFF;
-	uint32_t b = color & 0xFF;
-
-	r = (r * cfg->brightness) / 100;
-	g = (g * cfg->brightness) / 100;
-	b = (b * cfg->brightness) / 100;
-	w = (w * cfg->brightness) / 100;
-
-	//r = gamma_table[r];
-	//g = gamma_table[g];
-	//b = gamma_table[b];
-	//w = gamma_table[w];
-	
-	if (cfg->bits == 32) {
-		return (g << 24) | (r << 16) | (b << 8) | w;
-	} else {
-		return (g << 16) | (r << 8) | b;
-	}
-}
+// One strip can be driven on each of TIM3/TIM4 CH1/CH2. The handle returned by
+// ext-ws2812-init is the index into strips.
+#define MAX_STRIPS			4
+
+typedef struct {
+	ws_cfg *strips[MAX_STRIPS];
+	int current;
+	lib_mutex anim_mutex; // Shared by the strips, mutexes cannot be freed
+} ws_state;
 
-static void ws2812_init(ws_cfg *cfg) {
+// The two channels of a timer share the time base, so it is only set up by the
+// first strip on that timer and left running until the last one is stopped.
+static void ws2812_init(ws_cfg *cfg, bool tim_in_use) {
 	TIM_TimeBaseInitTypeDef  TIM_TimeBaseStructure;
 	TIM_OCInitTypeDef  TIM_OCInitStructure;
 	DMA_InitTypeDef DMA_InitStructure;
 
+	ws2812_enc_update_lut(&cfg->enc, cfg->brightness, cfg->gamma);
+
 	// Default LED values
-	int i, bit;
+	int i;
 
 	for (i = 0;i < cfg->ledbuf_len;i++) {
 		cfg->RGBdata[i] = 0;
 	}
 
-	for (i = 0;i < cfg->ledbuf_len;i++) {
-		uint32_t tmp_color = rgb_to_local(cfg, cfg->RGBdata[i]);
-
-		for (bit = 0;bit < cfg->bits;bit++) {
-			if (tmp_color & (1 << (cfg->bits - 1))) {
-				cfg->bitbuffer[bit + i * cfg->bits] = WS2812_ONE;
-			} else {
-				cfg->bitbuffer[bit + i * cfg->bits] = WS2812_ZERO;
-			}
-			tmp_color <<= 1;
+	if (cfg->stream) {
+		// The window is filled by the stream thread when a frame is sent, keep
+		// the output low until then.
+		for (i = 0;i < cfg->bitbuf_len;i++) {
+			cfg->bitbuffer[i] = 0;
+		}
+	} else {
+		for (i = 0;i < cfg->ledbuf_len;i++) {
+			ws2812_enc_color(&cfg->enc, cfg->RGBdata[i], cfg->bitbuffer + i * cfg->enc.bits);
 		}
-	}
 
-	// Fill the rest of the buffer with zeros to give the LEDs a chance to update
-	// after sending all bits
-	for (i = 0;i < BITBUFFER_PAD;i++) {
-		cfg->bitbuffer[cfg->bitbuf_len - BITBUFFER_PAD - 1 + i] = 0;
+		// Fill the rest of the buffer with zeros to give the LEDs a chance to update
+		// after sending all bits
+		for (i = 0;i < BITBUFFER_PAD;i++) {
+			cfg->bitbuffer[cfg->bitbuf_len - BITBUFFER_PAD - 1 + i] = 0;
+		}
 	}
 
-	// Generate gamma correction table
-	//for (i = 0;i < 256;i++) {
-	//	gamma_table[i] = (int)roundf(powf((float)i / 255.0, 1.0 / 0.45) * 255.0);
-	//}
-	
 	TIM_TypeDef *tim;
 	DMA_Stream_TypeDef *dma_stream;
 	uint32_t dma_ch;
@@ -111,6 +154,8 @@ static void ws2812_init(ws_cfg *cfg) {
 		if (cfg->is_ch2) {
 			dma_stream = DMA1_Stream3;
 			dma_ch = DMA_Channel_2;
+			cfg->flag_ht = DMA_FLAG_HTIF3;
+			cfg->flag_tc = DMA_FLAG_TCIF3;
 			VESC_IF->set_pad_mode(GPIOB, 7,
 				PAL_MODE_ALTERNATE(2) |
 				PAL_STM32_OTYPE_OPENDRAIN |
@@ -118,6 +163,8 @@ static void ws2812_init(ws_cfg *cfg) {
 		} else {
 			dma_stream = DMA1_Stream0;
 			dma_ch = DMA_Channel_2;
+			cfg->flag_ht = DMA_FLAG_HTIF0;
+			cfg->flag_tc = DMA_FLAG_TCIF0;
 			VESC_IF->set_pad_mode(GPIOB, 6,
 				PAL_MODE_ALTERNATE(2) |
 				PAL_STM32_OTYPE_OPENDRAIN |
@@ -128,6 +175,8 @@ static void ws2812_init(ws_cfg *cfg) {
 		if (cfg->is_ch2) {
 			dma_stream = DMA1_Stream5;
 			dma_ch = DMA_Channel_5;
+			cfg->flag_ht = DMA_FLAG_HTIF5;
+			cfg->flag_tc = DMA_FLAG_TCIF5;
 			VESC_IF->set_pad_mode(GPIOC, 7,
 				PAL_MODE_ALTERNATE(2) |
 				PAL_STM32_OTYPE_OPENDRAIN |
@@ -135,6 +184,8 @@ static void ws2812_init(ws_cfg *cfg) {
 		} else {
 			dma_stream = DMA1_Stream4;
 			dma_ch = DMA_Channel_5;
+			cfg->flag_ht = DMA_FLAG_HTIF4;
+			cfg->flag_tc = DMA_FLAG_TCIF4;
 			VESC_IF->set_pad_mode(GPIOC, 6,
 				PAL_MODE_ALTERNATE(2) |
 				PAL_STM32_OTYPE_OPENDRAIN |
@@ -142,7 +193,12 @@ static void ws2812_init(ws_cfg *cfg) {
 		}
 	}
 	
-	TIM_DeInit(tim);
+	cfg->tim = tim;
+	cfg->dma_stream = dma_stream;
+
+	if (!tim_in_use) {
+		TIM_DeInit(tim);
+	}
 
 	RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA1 , ENABLE);
 	DMA_DeInit(dma_stream);
@@ -170,19 +226,21 @@ static void ws2812_init(ws_cfg *cfg) {
 
 	DMA_Init(dma_stream, &DMA_InitStructure);
 	
-	if (cfg->is_tim4) {
-		RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM4, ENABLE);
-	} else {
-		RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3, ENABLE);
-	}
+	if (!tim_in_use) {
+		if (cfg->is_tim4) {
+			RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM4, ENABLE);
+		} else {
+			RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3, ENABLE);
+		}
 
-	TIM_TimeBaseStructure.TIM_Prescaler = 0;
-	TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
-	TIM_TimeBaseStructure.TIM_Period = TIM_PERIOD;
-	TIM_TimeBaseStructure.TIM_ClockDivision = 0;
-	TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+		TIM_TimeBaseStructure.TIM_Prescaler = 0;
+		TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+		TIM_TimeBaseStructure.TIM_Period = TIM_PERIOD;
+		TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+		TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
 
-	TIM_TimeBaseInit(tim, &TIM_TimeBaseStructure);
+		TIM_TimeBaseInit(tim, &TIM_TimeBaseStructure);
+	}
 
 	TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_PWM1;
 	TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Enable;
@@ -197,11 +255,15 @@ static void ws2812_init(ws_cfg *cfg) {
 		TIM_OC1PreloadConfig(tim, TIM_OCPreload_Enable);
 	}
 	
-	TIM_ARRPreloadConfig(tim, ENABLE);
-
-	TIM_Cmd(tim, ENABLE);
+	if (!tim_in_use) {
+		TIM_ARRPreloadConfig(tim, ENABLE);
+		TIM_Cmd(tim, ENABLE);
+	}
 
-	DMA_Cmd(dma_stream, ENABLE);
+	// In streaming mode the DMA is only enabled while a frame is sent
+	if (!cfg->stream) {
+		DMA_Cmd(dma_stream, ENABLE);
+	}
 
 	if (cfg->is_ch2) {
 		TIM_DMACmd(tim, TIM_DMA_CC2, ENABLE);
@@ -214,30 +276,300 @@ static void ws2812_set_color(ws_cfg *cfg, int led, uint32_t color) {
 	if (led >= 0 && led < cfg->num_leds) {
 		cfg->RGBdata[led] = color;
 
-		color = rgb_to_local(cfg, color);
+		if (cfg->stream) {
+			cfg->frame_pending = true;
+		} else {
+			ws2812_enc_color(&cfg->enc, color, cfg->bitbuffer + led * cfg->enc.bits);
+		}
+	}
+}
+
+// Re-encodes the given range after RGBdata has been updated
+static void ws2812_update_range(ws_cfg *cfg, int start, int count) {
+	if (cfg->stream) {
+		cfg->frame_pending = true;
+		return;
+	}
 
-		int bit;
-		for (bit = 0;bit < cfg->bits;bit++) {
-			if (color & (1 << (cfg->bits - 1))) {
-				cfg->bitbuffer[bit + led * cfg->bits] = WS2812_ONE;
-			} else {
-				cfg->bitbuffer[bit + led * cfg->bits] = WS2812_ZERO;
+	ws2812_enc_range(&cfg->enc, cfg->RGBdata + start, count, cfg->bitbuffer + start * cfg->enc.bits);
+}
+
+// Clips start and count to the strip. Returns false if nothing is left.
+static bool ws2812_clip_range(ws_cfg *cfg, int *start, int *count) {
+	if (*count <= 0 || *start >= cfg->num_leds) {
+		return false;
+	}
+
+	// The signs differ here, so the sum cannot overflow
+	if (*start < 0) {
+		*count += *start;
+		*start = 0;
+	}
+
+	// Compared this way as start + count can overflow
+	if (*count > cfg->num_leds - *start) {
+		*count = cfg->num_leds - *start;
+	}
+
+	return *count > 0;
+}
+
+// Packed colors are stored as r, g, b and w if the strip is RGBW
+static uint32_t ws2812_unpack_color(ws_cfg *cfg, const uint8_t *data) {
+	uint32_t color = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | (uint32_t)data[2];
+
+	if (cfg->enc.bits == 32) {
+		color |= (uint32_t)data[3] << 24;
+	}
+
+	return color;
+}
+
+static void ws2812_reverse(uint32_t *data, int len) {
+	for (int i = 0;i < len / 2;i++) {
+		uint32_t tmp = data[i];
+		data[i] = data[len - i - 1];
+		data[len - i - 1] = tmp;
+	}
+}
+
+/*
+ * Streaming mode
+ *
+ * Instead of keeping one compare value per bit for the whole strip, only a window of
+ * 2 * STREAM_LEDS LEDs is kept. The DMA runs in circular mode over the window and the
+ * stream thread re-encodes the half that just finished from RGBdata while the other
+ * half is being sent. The library interface has no way to hook the DMA interrupts,
+ * so the half-transfer and transfer-complete flags are polled from the thread. To
+ * bound the refill latency the thread only sleeps while the next half is further
+ * away than STREAM_SLEEP_MARGIN_US, which it computes from the DMA position, and
+ * busy-polls after that. With the small window that means that most of the time
+ * while a frame is sent is spent polling, so frames are only sent when something
+ * changed and the output is kept low in between.
+ */
+
+static void stream_fill_half(ws_cfg *cfg, int half) {
+	int half_len = cfg->bitbuf_len / 2;
+	uint16_t *dst = cfg->bitbuffer + half * half_len;
+
+	if (cfg->stream_led >= cfg->num_leds) {
+		// A zero half is longer than the reset time, so the frame ends with it
+		for (int i = 0;i < half_len;i++) {
+			dst[i] = 0;
+		}
+
+		cfg->half_is_pad[half] = true;
+		return;
+	}
+
+	for (int i = 0;i < STREAM_LEDS;i++) {
+		if (cfg->stream_led < cfg->num_leds) {
+			ws2812_enc_color(&cfg->enc, cfg->RGBdata[cfg->stream_led++], dst + i * cfg->enc.bits);
+		} else {
+			for (int bit = 0;bit < cfg->enc.bits;bit++) {
+				dst[i * cfg->enc.bits + bit] = 0;
 			}
-			color <<= 1;
 		}
 	}
+
+	cfg->half_is_pad[half] = false;
+}
+
+static void stream_stop_dma(ws_cfg *cfg) {
+	DMA_Cmd(cfg->dma_stream, DISABLE);
+	while (DMA_GetCmdStatus(cfg->dma_stream) != DISABLE) {}
+	DMA_ClearFlag(cfg->dma_stream, cfg->flag_ht | cfg->flag_tc);
+
+	// Make sure that the output stays low if the frame was aborted mid-bit
+	if (cfg->is_ch2) {
+		cfg->tim->CCR2 = 0;
+	} else {
+		cfg->tim->CCR1 = 0;
+	}
+}
+
+// Aborts the frame when the thread did not keep up. The output is held low for the
+// reset time, so the LEDs keep what they got and the next frame starts over.
+static void stream_abort(ws_cfg *cfg) {
+	stream_stop_dma(cfg);
+	VESC_IF->sleep_us(STREAM_RESET_US);
+}
+
+// Sleeps until shortly before the DMA reaches the end of the current half, or
+// returns right away when that is closer than the margin
+static void stream_wait(ws_cfg *cfg) {
+	int half_len = cfg->bitbuf_len / 2;
+	int pos = cfg->bitbuf_len - (int)DMA_GetCurrDataCounter(cfg->dma_stream);
+	int left = (pos < half_len ? half_len : cfg->bitbuf_len) - pos;
+	int left_us = (left * 1000000) / WS2812_CLK_HZ;
+
+	if (left_us > STREAM_SLEEP_MARGIN_US) {
+		VESC_IF->sleep_us(left_us - STREAM_SLEEP_MARGIN_US);
+	}
+}
+
+// Returns false if the thread did not keep up and the frame was aborted
+static bool stream_frame(ws_cfg *cfg) {
+	cfg->frame_pending = false;
+	cfg->stream_led = 0;
+
+	stream_fill_half(cfg, 0);
+	stream_fill_half(cfg, 1);
+
+	DMA_ClearFlag(cfg->dma_stream, cfg->flag_ht | cfg->flag_tc);
+	DMA_SetCurrDataCounter(cfg->dma_stream, cfg->bitbuf_len);
+	DMA_Cmd(cfg->dma_stream, ENABLE);
+
+	int next = 0;
+
+	for (;;) {
+		uint32_t flag = next == 0 ? cfg->flag_ht : cfg->flag_tc;
+		uint32_t other = next == 0 ? cfg->flag_tc : cfg->flag_ht;
+
+		if (DMA_GetFlagStatus(cfg->dma_stream, flag) == RESET) {
+			stream_wait(cfg);
+			continue;
+		}
+
+		// Both halves done means that the DMA already is sending stale data
+		if (DMA_GetFlagStatus(cfg->dma_stream, other) != RESET) {
+			stream_abort(cfg);
+			return false;
+		}
+
+		DMA_ClearFlag(cfg->dma_stream, flag);
+
+		if (cfg->half_is_pad[next]) {
+			break;
+		}
+
+		stream_fill_half(cfg, next);
+
+		// The DMA got to this half while it was being filled, so part of it went
+		// out with the old data
+		if (DMA_GetFlagStatus(cfg->dma_stream, other) != RESET) {
+			stream_abort(cfg);
+			return false;
+		}
+
+		next = 1 - next;
+	}
+
+	stream_stop_dma(cfg);
+	return true;
+}
+
+static void stream_thd(void *arg) {
+	ws_cfg *cfg = (ws_cfg*)arg;
+	int backoff_ms = 0;
+
+	while (!VESC_IF->should_terminate()) {
+		if (!cfg->frame_pending) {
+			VESC_IF->sleep_ms(1);
+			continue;
+		}
+
+		if (stream_frame(cfg)) {
+			backoff_ms = 0;
+			continue;
+		}
+
+		// The strip shows a partial frame now, so the frame stays pending until
+		// it has been sent completely. The delay leaves time to the threads that
+		// kept this one from refilling.
+		cfg->frame_pending = true;
+		backoff_ms = backoff_ms == 0 ? 1 : backoff_ms * 2;
+		if (backoff_ms > STREAM_MAX_BACKOFF_MS) {
+			backoff_ms = STREAM_MAX_BACKOFF_MS;
+		}
+		VESC_IF->sleep_ms(backoff_ms);
+	}
+}
+
+// The strip that the extensions operate on
+static ws_cfg *current_cfg(void) {
+	ws_state *state = (ws_state*)ARG;
+	if (!state) {
+		return 0;
+	}
+
+	return state->strips[state->current];
+}
+
+static void ws2812_stop_strip(ws_state *state, ws_cfg *cfg) {
+	if (cfg->anim_thd) {
+		VESC_IF->request_terminate(cfg->anim_thd);
+	}
+
+	if (cfg->stream_thd) {
+		VESC_IF->request_terminate(cfg->stream_thd);
+	}
+
+	bool tim_in_use = false;
+	for (int i = 0;i < MAX_STRIPS;i++) {
+		ws_cfg *other = state->strips[i];
+		if (other && other != cfg && other->is_tim4 == cfg->is_tim4) {
+			tim_in_use = true;
+		}
+	}
+
+	if (tim_in_use) {
+		// Only release this channel and keep the other strip running
+		if (cfg->is_ch2) {
+			TIM_DMACmd(cfg->tim, TIM_DMA_CC2, DISABLE);
+			cfg->tim->CCR2 = 0;
+		} else {
+			TIM_DMACmd(cfg->tim, TIM_DMA_CC1, DISABLE);
+			cfg->tim->CCR1 = 0;
+		}
+	} else {
+		TIM_DeInit(cfg->tim);
+	}
+
+	DMA_DeInit(cfg->dma_stream);
+
+	VESC_IF->free(cfg->bitbuffer);
+	VESC_IF->free(cfg->RGBdata);
+	VESC_IF->free(cfg);
 }
 
 static lbm_value ext_init(lbm_value *args, lbm_uint argn) {
-	if (argn != 4 || !VESC_IF->lbm_is_number(args[0]) || !VESC_IF->lbm_is_number(args[1]) ||
+	if ((argn != 4 && argn != 5) || !VESC_IF->lbm_is_number(args[0]) || !VESC_IF->lbm_is_number(args[1]) ||
 		!VESC_IF->lbm_is_number(args[2]) || !VESC_IF->lbm_is_number(args[3])) {
 		return VESC_IF->lbm_enc_sym_eerror;
 	}
+
+	if (argn == 5 && !VESC_IF->lbm_is_number(args[4])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
 	
-	if (ARG) {
+	ws_state *state = (ws_state*)ARG;
+	if (!state) {
+		state = VESC_IF->malloc(sizeof(ws_state));
+		if (!state) {
+			VESC_IF->lbm_set_error_reason("Not enough memory");
+			return VESC_IF->lbm_enc_sym_merror;
+		}
+
+		for (int i = 0;i < MAX_STRIPS;i++) {
+			state->strips[i] = 0;
+		}
+		state->current = 0;
+		state->anim_mutex = VESC_IF->mutex_create();
+
+		ARG = state;
+	}
+
+	bool is_ch2 = VESC_IF->lbm_dec_as_i32(args[1]);
+	bool is_tim4 = VESC_IF->lbm_dec_as_i32(args[2]);
+	int handle = (is_tim4 ? 2 : 0) + (is_ch2 ? 1 : 0);
+
+	if (state->strips[handle]) {
 		VESC_IF->lbm_set_error_reason("Already Initialized");
 		return VESC_IF->lbm_enc_sym_eerror;
 	}
+
+	bool tim_in_use = state->strips[handle ^ 1] != 0;
 	
 	ws_cfg *cfg = VESC_IF->malloc(sizeof(ws_cfg));
 	
@@ -245,14 +577,27 @@ static lbm_value ext_init(lbm_value *args, lbm_uint argn) {
 	
 	if (cfg) {
 		cfg->num_leds = VESC_IF->lbm_dec_as_i32(args[0]);
-		cfg->is_ch2 = VESC_IF->lbm_dec_as_i32(args[1]);
-		cfg->is_tim4 = VESC_IF->lbm_dec_as_i32(args[2]);
-		cfg->bits = VESC_IF->lbm_dec_as_i32(args[3]) == 0 ? 24 : 32;
+		cfg->is_ch2 = is_ch2;
+		cfg->is_tim4 = is_tim4;
+		cfg->enc.bits = VESC_IF->lbm_dec_as_i32(args[3]) == 0 ? 24 : 32;
+		cfg->stream = argn == 5 && VESC_IF->lbm_dec_as_i32(args[4]) != 0;
 		cfg->ledbuf_len = cfg->num_leds + 1;
-		cfg->bitbuf_len = cfg->bits * cfg->ledbuf_len + BITBUFFER_PAD;
+		if (cfg->stream) {
+			cfg->bitbuf_len = 2 * STREAM_LEDS * cfg->enc.bits;
+		} else {
+			cfg->bitbuf_len = cfg->enc.bits * cfg->ledbuf_len + BITBUFFER_PAD;
+		}
 		cfg->bitbuffer = VESC_IF->malloc(sizeof(uint16_t) * cfg->bitbuf_len);
 		cfg->RGBdata = VESC_IF->malloc(sizeof(uint32_t) * cfg->ledbuf_len);
 		cfg->brightness = 100;
+		cfg->gamma = false;
+		cfg->frame_pending = false;
+		cfg->stream_thd = 0;
+		cfg->anim_mutex = state->anim_mutex;
+		cfg->anim.type = ANIM_OFF;
+		cfg->anim_rate = ANIM_RATE_DEFAULT;
+		cfg->anim_start = 0.0;
+		cfg->anim_thd = 0;
 		
 		ok = cfg->bitbuffer != NULL && cfg->RGBdata != NULL;
 	}
@@ -272,29 +617,46 @@ static lbm_value ext_init(lbm_value *args, lbm_uint argn) {
 		return VESC_IF->lbm_enc_sym_merror;
 	}
 	
-	ws2812_init(cfg);
+	ws2812_init(cfg, tim_in_use);
+
+	if (cfg->stream) {
+		cfg->stream_thd = VESC_IF->spawn(stream_thd, 512, "WS2812 Stream", cfg);
+		if (!cfg->stream_thd) {
+			ws2812_stop_strip(state, cfg);
+			VESC_IF->lbm_set_error_reason("Could not start thread");
+			return VESC_IF->lbm_enc_sym_merror;
+		}
+	}
 	
-	ARG = cfg;
+	state->strips[handle] = cfg;
+	state->current = handle;
 	
-	return VESC_IF->lbm_enc_sym_true;
+	return VESC_IF->lbm_enc_i(handle);
 }
 
 static lbm_value ext_set_brightness(lbm_value *args, lbm_uint argn) {
-	if (argn != 1 || !VESC_IF->lbm_is_number(args[0])) {
+	if ((argn != 1 && argn != 2) || !VESC_IF->lbm_is_number(args[0])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	if (argn == 2 && !VESC_IF->lbm_is_number(args[1])) {
 		return VESC_IF->lbm_enc_sym_eerror;
 	}
 	
-	ws_cfg *cfg = (ws_cfg*)ARG;
+	ws_cfg *cfg = current_cfg();
 	if (!cfg) {
 		VESC_IF->lbm_set_error_reason("Not Initialized");
 		return VESC_IF->lbm_enc_sym_eerror;
 	}
 	
 	cfg->brightness = VESC_IF->lbm_dec_as_u32(args[0]);
-
-	for (int i = 0;i < cfg->num_leds;i++) {
-		ws2812_set_color(cfg, i, cfg->RGBdata[i]);
+	if (argn == 2) {
+		cfg->gamma = VESC_IF->lbm_dec_as_i32(args[1]) != 0;
 	}
+
+	ws2812_enc_update_lut(&cfg->enc, cfg->brightness, cfg->gamma);
+
+	ws2812_update_range(cfg, 0, cfg->num_leds);
 	
 	return VESC_IF->lbm_enc_sym_true;
 }
@@ -304,7 +666,7 @@ static lbm_value ext_set_color(lbm_value *args, lbm_uint argn) {
 		return VESC_IF->lbm_enc_sym_eerror;
 	}
 	
-	ws_cfg *cfg = (ws_cfg*)ARG;
+	ws_cfg *cfg = current_cfg();
 	if (!cfg) {
 		VESC_IF->lbm_set_error_reason("Not Initialized");
 		return VESC_IF->lbm_enc_sym_eerror;
@@ -318,35 +680,448 @@ static lbm_value ext_set_color(lbm_value *args, lbm_uint argn) {
 	return VESC_IF->lbm_enc_sym_true;
 }
 
-static void stop(void *arg) {
-	if (arg) {
-		ws_cfg *cfg = (ws_cfg*)ARG;
-		
-		TIM_TypeDef *tim;
-		DMA_Stream_TypeDef *dma_stream;
-		
-		if (cfg->is_tim4) {
-			tim = TIM4;
-			if (cfg->is_ch2) {
-				dma_stream = DMA1_Stream3;
-			} else {
-				dma_stream = DMA1_Stream0;
+// (ext-ws2812-set-colors start colors), colors is a byte array with packed colors
+static lbm_value ext_set_colors(lbm_value *args, lbm_uint argn) {
+	if (argn != 2 || !VESC_IF->lbm_is_number(args[0]) || !VESC_IF->lbm_is_byte_array(args[1])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	ws_cfg *cfg = current_cfg();
+	if (!cfg) {
+		VESC_IF->lbm_set_error_reason("Not Initialized");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	lbm_array_header_t *array = (lbm_array_header_t *)VESC_IF->lbm_car(args[1]);
+	uint8_t *data = (uint8_t*)array->data;
+	int bytes_per_led = cfg->enc.bits / 8;
+
+	int start = VESC_IF->lbm_dec_as_i32(args[0]);
+	int count = array->size / bytes_per_led;
+	int first = start;
+
+	if (!ws2812_clip_range(cfg, &start, &count)) {
+		return VESC_IF->lbm_enc_sym_true;
+	}
+
+	int offset = start - first;
+
+	data += offset * bytes_per_led;
+	for (int i = start;i < start + count;i++) {
+		cfg->RGBdata[i] = ws2812_unpack_color(cfg, data);
+		data += bytes_per_led;
+	}
+
+	ws2812_update_range(cfg, start, count);
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ws2812-set-palette start indexes palette), indexes is a byte array with one
+// palette index per LED and palette is a byte array with packed colors
+static lbm_value ext_set_palette(lbm_value *args, lbm_uint argn) {
+	if (argn != 3 || !VESC_IF->lbm_is_number(args[0]) ||
+			!VESC_IF->lbm_is_byte_array(args[1]) || !VESC_IF->lbm_is_byte_array(args[2])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	ws_cfg *cfg = current_cfg();
+	if (!cfg) {
+		VESC_IF->lbm_set_error_reason("Not Initialized");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	lbm_array_header_t *ind_array = (lbm_array_header_t *)VESC_IF->lbm_car(args[1]);
+	lbm_array_header_t *pal_array = (lbm_array_header_t *)VESC_IF->lbm_car(args[2]);
+	uint8_t *indexes = (uint8_t*)ind_array->data;
+	uint8_t *palette = (uint8_t*)pal_array->data;
+	int bytes_per_led = cfg->enc.bits / 8;
+	int pal_len = pal_array->size / bytes_per_led;
+
+	int start = VESC_IF->lbm_dec_as_i32(args[0]);
+	int count = ind_array->size;
+	int first = start;
+
+	if (!ws2812_clip_range(cfg, &start, &count)) {
+		return VESC_IF->lbm_enc_sym_true;
+	}
+
+	int offset = start - first;
+
+	indexes += offset;
+	for (int i = start;i < start + count;i++) {
+		uint8_t ind = *indexes++;
+		cfg->RGBdata[i] = ind < pal_len ? ws2812_unpack_color(cfg, palette + ind * bytes_per_led) : 0;
+	}
+
+	ws2812_update_range(cfg, start, count);
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ws2812-fill color optStart optCount)
+static lbm_value ext_fill(lbm_value *args, lbm_uint argn) {
+	if (argn < 1 || argn > 3) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	for (lbm_uint i = 0;i < argn;i++) {
+		if (!VESC_IF->lbm_is_number(args[i])) {
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+	}
+
+	ws_cfg *cfg = current_cfg();
+	if (!cfg) {
+		VESC_IF->lbm_set_error_reason("Not Initialized");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	uint32_t color = VESC_IF->lbm_dec_as_u32(args[0]);
+	int start = argn >= 2 ? VESC_IF->lbm_dec_as_i32(args[1]) : 0;
+	int count = argn >= 3 ? VESC_IF->lbm_dec_as_i32(args[2]) : cfg->num_leds;
+
+	if (!ws2812_clip_range(cfg, &start, &count)) {
+		return VESC_IF->lbm_enc_sym_true;
+	}
+
+	for (int i = start;i < start + count;i++) {
+		cfg->RGBdata[i] = color;
+	}
+
+	if (cfg->stream) {
+		cfg->frame_pending = true;
+	} else {
+		ws2812_enc_fill(&cfg->enc, color, count, cfg->bitbuffer + start * cfg->enc.bits);
+	}
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ws2812-shift steps optRotate optStart optCount), positive steps move the colors
+// towards higher indexes. Without rotation the LEDs that are shifted in are turned off.
+static lbm_value ext_shift(lbm_value *args, lbm_uint argn) {
+	if (argn < 1 || argn > 4) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	for (lbm_uint i = 0;i < argn;i++) {
+		if (!VESC_IF->lbm_is_number(args[i])) {
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+	}
+
+	ws_cfg *cfg = current_cfg();
+	if (!cfg) {
+		VESC_IF->lbm_set_error_reason("Not Initialized");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	int steps = VESC_IF->lbm_dec_as_i32(args[0]);
+	bool rotate = argn >= 2 && VESC_IF->lbm_dec_as_i32(args[1]) != 0;
+	int start = argn >= 3 ? VESC_IF->lbm_dec_as_i32(args[2]) : 0;
+	int count = argn >= 4 ? VESC_IF->lbm_dec_as_i32(args[3]) : cfg->num_leds;
+
+	if (!ws2812_clip_range(cfg, &start, &count)) {
+		return VESC_IF->lbm_enc_sym_true;
+	}
+
+	uint32_t *data = cfg->RGBdata + start;
+
+	if (rotate) {
+		steps %= count;
+		if (steps < 0) {
+			steps += count;
+		}
+
+		if (steps == 0) {
+			return VESC_IF->lbm_enc_sym_true;
+		}
+
+		// Rotate right in place by three reversals
+		ws2812_reverse(data, count);
+		ws2812_reverse(data, steps);
+		ws2812_reverse(data + steps, count - steps);
+	} else {
+		int abs_steps = steps < 0 ? -steps : steps;
+		if (abs_steps > count) {
+			abs_steps = count;
+		}
+
+		int keep = count - abs_steps;
+
+		if (steps > 0) {
+			memmove(data + abs_steps, data, keep * sizeof(uint32_t));
+			memset(data, 0, abs_steps * sizeof(uint32_t));
+		} else if (steps < 0) {
+			memmove(data, data + abs_steps, keep * sizeof(uint32_t));
+			memset(data + keep, 0, abs_steps * sizeof(uint32_t));
+		} else {
+			return VESC_IF->lbm_enc_sym_true;
+		}
+	}
+
+	ws2812_update_range(cfg, start, count);
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+/*
+ * Animations
+ *
+ * The animation thread renders the selected effect into RGBdata at a fixed rate, so
+ * that LispBM only has to change the parameters instead of pushing every pixel.
+ */
+
+// Linear interpolation between the channels of c1 and c2, f = 0 gives c1
+static uint32_t color_mix(uint32_t c1, uint32_t c2, float f) {
+	if (f <= 0.0) {
+		return c1;
+	} else if (f >= 1.0) {
+		return c2;
+	}
+
+	uint32_t res = 0;
+	for (int shift = 0;shift < 32;shift += 8) {
+		float a = (c1 >> shift) & 0xFF;
+		float b = (c2 >> shift) & 0xFF;
+		res |= (uint32_t)(a + (b - a) * f) << shift;
+	}
+
+	return res;
+}
+
+// Lights the first fraction of the strip with color and the rest with background
+static void anim_bar(ws_cfg *cfg, float fraction, uint32_t color, uint32_t background) {
+	float lit = fraction * (float)cfg->num_leds;
+
+	for (int i = 0;i < cfg->num_leds;i++) {
+		cfg->RGBdata[i] = color_mix(background, color, lit - (float)i);
+	}
+}
+
+static void anim_render(ws_cfg *cfg, const anim_params *p, float t) {
+	int num = cfg->num_leds;
+
+	switch (p->type) {
+	case ANIM_SOLID:
+		for (int i = 0;i < num;i++) {
+			cfg->RGBdata[i] = p->color1;
+		}
+		break;
+
+	case ANIM_GRADIENT: {
+		// Triangle wave between the colors so that scrolling wraps seamlessly
+		float offset = t * p->speed;
+		for (int i = 0;i < num;i++) {
+			float pos = fmodf(((float)i + offset) / (float)num, 1.0);
+			if (pos < 0.0) {
+				pos += 1.0;
+			}
+			float f = pos < 0.5 ? 2.0 * pos : 2.0 - 2.0 * pos;
+			cfg->RGBdata[i] = color_mix(p->color1, p->color2, f);
+		}
+	} break;
+
+	case ANIM_CHASE: {
+		// param is the tail length in LEDs
+		float len = p->param >= 1.0 ? p->param : 1.0;
+		float head = fmodf(t * p->speed, (float)num);
+		if (head < 0.0) {
+			head += (float)num;
+		}
+
+		for (int i = 0;i < num;i++) {
+			float dist = head - (float)i;
+			if (dist < 0.0) {
+				dist += (float)num;
 			}
+			cfg->RGBdata[i] = color_mix(p->color1, p->color2, dist / len);
+		}
+	} break;
+
+	case ANIM_BREATHING: {
+		float f = 0.5 + 0.5 * cosf(2.0 * M_PI * p->speed * t);
+		for (int i = 0;i < num;i++) {
+			cfg->RGBdata[i] = color_mix(p->color1, p->color2, f);
+		}
+	} break;
+
+	case ANIM_BATTERY: {
+		// Goes from color2 when empty to color1 when full
+		float level = VESC_IF->mc_get_battery_level(0);
+		anim_bar(cfg, level, color_mix(p->color2, p->color1, level), 0);
+	} break;
+
+	case ANIM_SPEED: {
+		// param is the speed in m/s that lights the whole strip
+		float max = p->param > 0.0 ? p->param : 1.0;
+		anim_bar(cfg, fabsf(VESC_IF->mc_get_speed()) / max, p->color1, p->color2);
+	} break;
+
+	default:
+		return;
+	}
+
+	ws2812_update_range(cfg, 0, num);
+}
+
+static void anim_thd(void *arg) {
+	ws_cfg *cfg = (ws_cfg*)arg;
+
+	while (!VESC_IF->should_terminate()) {
+		uint32_t frame_start = VESC_IF->timer_time_now();
+
+		VESC_IF->mutex_lock(cfg->anim_mutex);
+		anim_params p = cfg->anim;
+		float start = cfg->anim_start;
+		VESC_IF->mutex_unlock(cfg->anim_mutex);
+
+		anim_render(cfg, &p, VESC_IF->system_time() - start);
+
+		float frame_time = 1.0 / (float)cfg->anim_rate;
+		float left = frame_time - VESC_IF->timer_seconds_elapsed_since(frame_start);
+
+		if (left > 0.001) {
+			VESC_IF->sleep_us((uint32_t)(left * 1.0e6));
 		} else {
-			tim = TIM3;
-			if (cfg->is_ch2) {
-				dma_stream = DMA1_Stream5;
-			} else {
-				dma_stream = DMA1_Stream4;
+			VESC_IF->sleep_ms(1);
+		}
+	}
+}
+
+// (ext-ws2812-anim effect optColor1 optColor2 optSpeed optParam)
+static lbm_value ext_anim(lbm_value *args, lbm_uint argn) {
+	if (argn < 1 || argn > 5) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	for (lbm_uint i = 0;i < argn;i++) {
+		if (!VESC_IF->lbm_is_number(args[i])) {
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+	}
+
+	ws_cfg *cfg = current_cfg();
+	if (!cfg) {
+		VESC_IF->lbm_set_error_reason("Not Initialized");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	int type = VESC_IF->lbm_dec_as_i32(args[0]);
+	if (type < ANIM_OFF || type > ANIM_SPEED) {
+		VESC_IF->lbm_set_error_reason("Unknown Effect");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	anim_params p;
+	p.type = type;
+	p.color1 = argn >= 2 ? VESC_IF->lbm_dec_as_u32(args[1]) : 0;
+	p.color2 = argn >= 3 ? VESC_IF->lbm_dec_as_u32(args[2]) : 0;
+	p.speed = argn >= 4 ? VESC_IF->lbm_dec_as_float(args[3]) : 1.0;
+	p.param = argn >= 5 ? VESC_IF->lbm_dec_as_float(args[4]) : 0.0;
+
+	// The thread only runs while an animation is active and is started again
+	// when the next one is set
+	if (p.type == ANIM_OFF && cfg->anim_thd) {
+		VESC_IF->request_terminate(cfg->anim_thd);
+		cfg->anim_thd = 0;
+	}
+
+	VESC_IF->mutex_lock(cfg->anim_mutex);
+	if (p.type != cfg->anim.type) {
+		cfg->anim_start = VESC_IF->system_time();
+	}
+	cfg->anim = p;
+	VESC_IF->mutex_unlock(cfg->anim_mutex);
+
+	if (!cfg->anim_thd && p.type != ANIM_OFF) {
+		cfg->anim_thd = VESC_IF->spawn(anim_thd, 1024, "WS2812 Anim", cfg);
+		if (!cfg->anim_thd) {
+			cfg->anim.type = ANIM_OFF;
+			VESC_IF->lbm_set_error_reason("Could not start thread");
+			return VESC_IF->lbm_enc_sym_merror;
+		}
+	}
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ws2812-anim-rate hz)
+static lbm_value ext_anim_rate(lbm_value *args, lbm_uint argn) {
+	if (argn != 1 || !VESC_IF->lbm_is_number(args[0])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	ws_cfg *cfg = current_cfg();
+	if (!cfg) {
+		VESC_IF->lbm_set_error_reason("Not Initialized");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	int rate = VESC_IF->lbm_dec_as_i32(args[0]);
+	if (rate < 1 || rate > 1000) {
+		VESC_IF->lbm_set_error_reason("Invalid Rate");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	cfg->anim_rate = rate;
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ws2812-select handle), selects the strip that the other extensions operate on
+static lbm_value ext_select(lbm_value *args, lbm_uint argn) {
+	if (argn != 1 || !VESC_IF->lbm_is_number(args[0])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	ws_state *state = (ws_state*)ARG;
+	int handle = VESC_IF->lbm_dec_as_i32(args[0]);
+
+	if (!state || handle < 0 || handle >= MAX_STRIPS || !state->strips[handle]) {
+		VESC_IF->lbm_set_error_reason("Not Initialized");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	state->current = handle;
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-ws2812-deinit handle), stops the strip and frees its memory, so that the pin
+// can be initialized again
+static lbm_value ext_deinit(lbm_value *args, lbm_uint argn) {
+	if (argn != 1 || !VESC_IF->lbm_is_number(args[0])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	ws_state *state = (ws_state*)ARG;
+	int handle = VESC_IF->lbm_dec_as_i32(args[0]);
+
+	if (!state || handle < 0 || handle >= MAX_STRIPS || !state->strips[handle]) {
+		VESC_IF->lbm_set_error_reason("Not Initialized");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	ws2812_stop_strip(state, state->strips[handle]);
+	state->strips[handle] = 0;
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+static void stop(void *arg) {
+	if (arg) {
+		ws_state *state = (ws_state*)ARG;
+
+		for (int i = 0;i < MAX_STRIPS;i++) {
+			if (state->strips[i]) {
+				ws2812_stop_strip(state, state->strips[i]);
+				state->strips[i] = 0;
 			}
 		}
-		
-		TIM_DeInit(tim);
-		DMA_DeInit(dma_stream);
-		
-		VESC_IF->free(cfg->bitbuffer);
-		VESC_IF->free(cfg->RGBdata);
-		VESC_IF->free(cfg);
+
+		VESC_IF->free(state);
 	}
 }
 
@@ -354,8 +1129,16 @@ INIT_FUN(lib_info *info) {
 	INIT_START
 
 	VESC_IF->lbm_add_extension("ext-ws2812-init", ext_init);
+	VESC_IF->lbm_add_extension("ext-ws2812-deinit", ext_deinit);
+	VESC_IF->lbm_add_extension("ext-ws2812-select", ext_select);
 	VESC_IF->lbm_add_extension("ext-ws2812-set-brightness", ext_set_brightness);
 	VESC_IF->lbm_add_extension("ext-ws2812-set-color", ext_set_color);
+	VESC_IF->lbm_add_extension("ext-ws2812-set-colors", ext_set_colors);
+	VESC_IF->lbm_add_extension("ext-ws2812-set-palette", ext_set_palette);
+	VESC_IF->lbm_add_extension("ext-ws2812-fill", ext_fill);
+	VESC_IF->lbm_add_extension("ext-ws2812-shift", ext_shift);
+	VESC_IF->lbm_add_extension("ext-ws2812-anim", ext_anim);
+	VESC_IF->lbm_add_extension("ext-ws2812-anim-rate", ext_anim_rate);
 	
 	info->arg = 0;
 	info->stop_fun = stop;
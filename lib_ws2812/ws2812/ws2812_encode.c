@@ -0,0 +1,95 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ws2812_encode.h"
+
+#include <math.h>
+#include <string.h>
+
+#define Z					((uint16_t)WS2812_ZERO)
+#define O					((uint16_t)WS2812_ONE)
+
+// Compare values for the 4 bits of each nibble, MSB first
+static const uint16_t nibble_table[16][4] = {
+	{Z, Z, Z, Z}, {Z, Z, Z, O}, {Z, Z, O, Z}, {Z, Z, O, O},
+	{Z, O, Z, Z}, {Z, O, Z, O}, {Z, O, O, Z}, {Z, O, O, O},
+	{O, Z, Z, Z}, {O, Z, Z, O}, {O, Z, O, Z}, {O, Z, O, O},
+	{O, O, Z, Z}, {O, O, Z, O}, {O, O, O, Z}, {O, O, O, O},
+};
+
+#undef Z
+#undef O
+
+void ws2812_enc_update_lut(ws2812_enc *enc, uint32_t brightness, bool gamma) {
+	for (int i = 0;i < 256;i++) {
+		uint32_t val = (i * brightness) / 100;
+
+		if (val > 255) {
+			val = 255;
+		}
+
+		if (gamma) {
+			val = (uint32_t)roundf(powf((float)val / 255.0, 1.0 / 0.45) * 255.0);
+		}
+
+		enc->color_lut[i] = val;
+	}
+}
+
+static uint32_t rgb_to_local(const ws2812_enc *enc, uint32_t color) {
+	uint32_t w = enc->color_lut[(color >> 24) & 0xFF];
+	uint32_t r = enc->color_lut[(color >> 16) & 0xFF];
+	uint32_t g = enc->color_lut[(color >> 8) & 0xFF];
+	uint32_t b = enc->color_lut[color & 0xFF];
+
+	if (enc->bits == 32) {
+		return (g << 24) | (r << 16) | (b << 8) | w;
+	} else {
+		return (g << 16) | (r << 8) | b;
+	}
+}
+
+void ws2812_enc_color(const ws2812_enc *enc, uint32_t color, uint16_t *dst) {
+	color = rgb_to_local(enc, color);
+
+	for (int shift = enc->bits - 4;shift >= 0;shift -= 4) {
+		memcpy(dst, nibble_table[(color >> shift) & 0x0F], sizeof(nibble_table[0]));
+		dst += 4;
+	}
+}
+
+// Encodes count colors into consecutive LEDs
+void ws2812_enc_range(const ws2812_enc *enc, const uint32_t *colors, int count, uint16_t *dst) {
+	for (int i = 0;i < count;i++) {
+		ws2812_enc_color(enc, colors[i], dst);
+		dst += enc->bits;
+	}
+}
+
+// All LEDs get the same bits, so encode once and copy
+void ws2812_enc_fill(const ws2812_enc *enc, uint32_t color, int count, uint16_t *dst) {
+	if (count <= 0) {
+		return;
+	}
+
+	ws2812_enc_color(enc, color, dst);
+	for (int i = 1;i < count;i++) {
+		memcpy(dst + i * enc->bits, dst, enc->bits * sizeof(uint16_t));
+	}
+}
@@ -0,0 +1,49 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WS2812_ENCODE_H_
+#define WS2812_ENCODE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Encoding of colors into timer compare values, one per bit. This part does not
+ * touch the hardware, so it is also built for the host benchmarks in c_libs/bench.
+ */
+
+#define WS2812_CLK_HZ		800000
+#define TIM_PERIOD			(((168000000 / 2 / WS2812_CLK_HZ) - 1))
+#define WS2812_ZERO			(TIM_PERIOD * 0.2)
+#define WS2812_ONE			(TIM_PERIOD * 0.8)
+
+typedef struct {
+	int bits; // 24 for RGB and 32 for RGBW strips
+
+	// Combined brightness and gamma correction for each channel value. Rebuilt
+	// when the brightness or the gamma setting changes.
+	uint8_t color_lut[256];
+} ws2812_enc;
+
+void ws2812_enc_update_lut(ws2812_enc *enc, uint32_t brightness, bool gamma);
+void ws2812_enc_color(const ws2812_enc *enc, uint32_t color, uint16_t *dst);
+void ws2812_enc_range(const ws2812_enc *enc, const uint32_t *colors, int count, uint16_t *dst);
+void ws2812_enc_fill(const ws2812_enc *enc, uint32_t color, int count, uint16_t *dst);
+
+#endif
@@ -1,3 +1,9 @@
+(import "logger/logger.bin" 'logger)
+(load-native-lib logger)
+
+(import "pkg::supervisor@://vesc_packages/lib_supervisor/supervisor.vescpkg" 'supervisor)
+(load-native-lib supervisor)
+
 ; State
 (def log-running false)
 (def last-can-id -1)
@@ -5,49 +11,109 @@
 ; Minimum input voltage, stop logging when voltage drops lower
 (def vin-min 9)
 
+; Triggered logging. When enabled the log is sent at trig-base-rate and
+; switches to the full log rate for trig-post-time seconds when one of the
+; triggers in trig-list fires, starting with the last trig-pre-time seconds
+; before the trigger. A voltage sag trigger is added at trig-vin-sag volts
+; above vin-min. See the README for the available triggers.
+(def trig-enabled false)
+(def trig-base-rate 1.0)
+(def trig-pre-time 2.0)
+(def trig-post-time 5.0)
+(def trig-vin-sag 3.0)
+(def trig-list '(
+        (fault . 1)
+        (current . 80.0)
+        (pitch . 0.6)
+))
+
+; The frames are delayed by the pre-trigger history, so in triggered mode
+; they carry their own timestamp.
+(def trig-time-row '("time" "s" "Time" 3 nil true (time)))
+
 ; Local data to log
 ;
 ; Format
-; (optKey optName optUnit optPrecision optIsRel optIsTime value-function)
+; (optKey optName optUnit optPrecision optIsRel optIsTime optRate optThreshold value-function)
 ;
 ; All entries except value-function are optional and
 ; default values will be used if they are left out.
+;
+; optRate is the rate in Hz at which the field is sampled, which must be
+; given as a float. It defaults to the log rate. optThreshold, also a float,
+; makes the field only update when the value changes more than that. In
+; both cases the last value is repeated in between, so every row still
+; has all fields.
+;
+; The value-function is either a native source such as (vin) or
+; (can-rpm id) that is sampled by the logger library, or any other
+; expression that is evaluated in lisp at the rate of the field. The native
+; sources are listed in the README.
 (def loglist-local '(
-        ("Input Voltage" "V"            (get-vin))
-        ("Current" "A"                  (get-current))
-        ("Current In" "A"               (get-current-in))
-        ("Duty"                         (get-duty))
-        ("RPM"                          (get-rpm))
-        ("Temp Fet" "degC" 1            (get-temp-fet))
-        ("Temp Motor" "degC" 1          (get-temp-mot))
-        ("Batt" "%"                     (* (get-batt) 100))
-        ("kmh_vesc" "km/h" "Speed VESC" (* (get-speed) 3.6))
-        ("roll"                         (ix (get-imu-rpy) 0))
-        ("pitch"                        (ix (get-imu-rpy) 1))
-        ("yaw"                          (ix (get-imu-rpy) 2))
-        ("fault"                        (get-fault))
-        ("trip_vesc" "m"                (get-dist))
-        ("trip_vesc_abs" "m"            (get-dist-abs))
-        ("cnt_ah" "Ah" "Amp Hours"      (get-ah))
-        ("cnt_wh" "Wh" "Watt Hours"     (get-wh))
-        ("cnt_ah_chg" "Ah" "Ah Chg"     (get-ah-chg))
-        ("cnt_wh_chg" "Wh" "Wh Chg"     (get-wh-chg))
+        ("Input Voltage" "V"            (vin))
+        ("Current" "A"                  (current))
+        ("Current In" "A"               (current-in))
+        ("Duty"                         (duty))
+        ("RPM"                          (rpm))
+        ("Temp Fet" "degC" 1 1.0        (temp-fet))
+        ("Temp Motor" "degC" 1 1.0      (temp-mot))
+        ("Batt" "%" 1.0                 (batt))
+        ("kmh_vesc" "km/h" "Speed VESC" (kmh))
+        ("roll"                         (roll))
+        ("pitch"                        (pitch))
+        ("yaw"                          (yaw))
+        ("fault" 0.0 0.5                (fault))
+        ("trip_vesc" "m"                (dist))
+        ("trip_vesc_abs" "m"            (dist-abs))
+        ("cnt_ah" "Ah" "Amp Hours" 5.0  (ah))
+        ("cnt_wh" "Wh" "Watt Hours" 5.0 (wh))
+        ("cnt_ah_chg" "Ah" "Ah Chg" 1.0 (ah-chg))
+        ("cnt_wh_chg" "Wh" "Wh Chg" 1.0 (wh-chg))
 ))
 
 ; CAN-data template. Same format as above, but all %d in strings will
 ; be replaced with can-id. Id in the last field will also be replaced
 ; with can id.
 (def loglist-can-template '(
-        ("V%d Current" "A"              (canget-current id))
-        ("V%d Current In" "A"           (canget-current-in id))
-        ("V%d Duty"                     (canget-duty id))
-        ("V%d RPM"                      (canget-rpm id))
-        ("V%d Temp Fet" "degC" 1        (canget-temp-fet id))
-        ("V%d Temp Motor" "degC" 1      (canget-temp-motor id))
+        ("V%d Current" "A"              (can-current id))
+        ("V%d Current In" "A"           (can-current-in id))
+        ("V%d Duty"                     (can-duty id))
+        ("V%d RPM"                      (can-rpm id))
+        ("V%d Temp Fet" "degC" 1 1.0    (can-temp-fet id))
+        ("V%d Temp Motor" "degC" 1 1.0  (can-temp-motor id))
 ))
 
 (defun merge-lists (list-with-lists) (foldl append () list-with-lists))
 
+(defun filter-list (f lst)
+    (foldl (fn (acc x) (if (f x) (append acc (list x)) acc)) () lst)
+)
+
+(defun is-native (row) (ext-logger-field-ok (ix row -1)))
+
+; The precision is the only integer in a row, 2 decimals when it is left out
+(defun row-precision (row)
+    (let ((p (first (filter-list (fn (x) (eq (type-of x) type-i)) row))))
+        (if p p 2)
+))
+
+(defun row-floats (row) (filter-list (fn (x) (eq (type-of x) type-float)) row))
+
+; Number of log samples per sample of this field. A rate of 0 means that the
+; log rate is used.
+(defun row-divider (row rate)
+    (let (
+            (f (row-floats row))
+            (div (if (and f (> (first f) 0.0)) (to-i (/ rate (first f))) 1))
+        )
+        (if (< div 1) 1 div)
+))
+
+(defun row-threshold (row)
+    (let ((f (row-floats row)))
+        (if (> (length f) 1) (ix f 1) 0.0)
+))
+
 ; Scan CAN-bus and make loglists for all devices
 (defun canlist-create ()
     (merge-lists
@@ -81,16 +147,18 @@
         )
         (if (< (get-bms-val 'bms-msg-age) 2)
             (progn
-                (add '("bms_v_tot" "V" "BMS Voltage" (get-bms-val 'bms-v-tot)))
+                ; The BMS values arrive over CAN at a few Hz, so they are
+                ; sampled at most at 5 Hz
+                (add '("bms_v_tot" "V" "BMS Voltage" 5.0 (get-bms-val 'bms-v-tot)))
                 (looprange i 0 (get-bms-val 'bms-cell-num)
-                    (add (list (str-from-n (+ i 1) "BMS_C%d") "V" 3 (list 'get-bms-val ''bms-v-cell i)))
+                    (add (list (str-from-n (+ i 1) "BMS_C%d") "V" 3 5.0 (list 'get-bms-val ''bms-v-cell i)))
                 )
-                (add '("bms_i_in_ic" "A" "BMS Current" (get-bms-val 'bms-i-in-ic)))
-                (add '("bms_soc" "%" "BMS SOC" (* (get-bms-val 'bms-soc) 100.0)))
-                (add '("bms_hum" "%" "BMS Hum" (get-bms-val 'bms-hum)))
-                (add '("bms_temp_hum" "degC" "BMS Temp Hum" (get-bms-val 'bms-temp-hum)))
+                (add '("bms_i_in_ic" "A" "BMS Current" 5.0 (get-bms-val 'bms-i-in-ic)))
+                (add '("bms_soc" "%" "BMS SOC" 1.0 (* (get-bms-val 'bms-soc) 100.0)))
+                (add '("bms_hum" "%" "BMS Hum" 1.0 (get-bms-val 'bms-hum)))
+                (add '("bms_temp_hum" "degC" "BMS Temp Hum" 1.0 (get-bms-val 'bms-temp-hum)))
                 (looprange i 0 (get-bms-val 'bms-temp-adc-num)
-                    (add (list (str-from-n (+ i 1) "BMS_T%d") "degC" 3 (list 'get-bms-val ''bms-temps-adc i)))
+                    (add (list (str-from-n (+ i 1) "BMS_T%d") "degC" 3 1.0 (list 'get-bms-val ''bms-temps-adc i)))
                 )
                 res
             )
@@ -140,17 +208,51 @@
             (print (list key name unit precision is-rel is-time (ix (ix lst row) -1)))
 )))
 
-(defun log-thd (id rate lst)
-    (loopwhile log-running
-        (progn
-            (log-send-f32 id 0
-                (map
-                    (fn (x) (eval (ix x -1)))
-                    lst
-                )
-            )
-            (sleep (/ 1.0 rate))
-)))
+; The frames from the logger library have the native fields followed by the
+; ones that are evaluated here, so they are sent as they are. Frames are only
+; available at the log rate outside of triggered mode.
+(defun log-thd (id field-num)
+    (loopwhile (and log-running (ext-logger-wait))
+        (let ((vals (ext-logger-get)))
+            (loopwhile vals
+                (progn
+                    (if (> field-num 0) (log-send-f32 id 0 vals))
+                    (setvar 'vals (ext-logger-get))
+)))))
+
+; Evaluates the fields that are not native at their own rates and passes
+; them to the logger library, which stores them with every frame. That way
+; the rows from the pre-trigger history get the values from their own time.
+; Each field is a list with (divider threshold expression last-value left),
+; where the divider and left, the samples until the field is due, count
+; samples at the log rate. The thread sleeps until the next field is due
+; instead of waking up for every sample.
+(defun eval-thd (rate lst)
+    (let ((first-run true) (step 0))
+        (loopwhile log-running
+            (progn
+                (setvar 'lst
+                    (map
+                        (fn (x)
+                            (if (= (ix x 4) 0)
+                                (let (
+                                        (old (ix x 3))
+                                        (new (eval (ix x 2)))
+                                    )
+                                    (list (ix x 0) (ix x 1) (ix x 2)
+                                        (if (or first-run (>= (abs (- new old)) (ix x 1))) new old)
+                                        (ix x 0)
+                                ))
+                                x
+                        ))
+                        lst
+                ))
+                (ext-logger-set-eval (map (fn (x) (ix x 3)) lst))
+                (setvar 'first-run false)
+                (setvar 'step (foldl (fn (acc x) (if (< (ix x 4) acc) (ix x 4) acc)) (ix (first lst) 4) lst))
+                (setvar 'lst (map (fn (x) (list (ix x 0) (ix x 1) (ix x 2) (ix x 3) (- (ix x 4) step))) lst))
+                (sleep (/ (to-float step) rate))
+))))
 
 (defun start-log (id append-gnss log-local log-can log-bms rate)
     (progn
@@ -164,18 +266,51 @@
                     (if log-bms (bmslist-create) ())
         )))
         
+        ; Native fields first, followed by the ones that are evaluated in lisp
+        (def loglist-native (filter-list is-native loglist))
+        (if trig-enabled
+            (def loglist-native (cons trig-time-row loglist-native))
+        )
+        (def loglist-eval (filter-list (fn (x) (not (is-native x))) loglist))
+        (def loglist (append loglist-native loglist-eval))
+        
         (log-configure id loglist)
         
         (log-start
             id ; CAN id
             (length loglist) ; Field num
             rate ; Rate Hz
-            true ; Append time
+            (not trig-enabled) ; Append time
             append-gnss ; Append gnss
         )
 
         (def log-running true)
-        (def log-thd-id (spawn log-thd id rate loglist))
+        (if trig-enabled
+            (ext-logger-set-trigger trig-base-rate trig-pre-time trig-post-time
+                (cons (cons 'vin (+ vin-min trig-vin-sag)) trig-list)
+            )
+            (ext-logger-set-trigger)
+        )
+        (ext-logger-start rate
+            (map (fn (x) (ix x -1)) loglist-native)
+            (map row-precision loglist)
+            (map (fn (x) (row-divider x rate)) loglist-native)
+            (map row-threshold loglist-native)
+            (length loglist-eval)
+        )
+        (def log-thd-id (spawn log-thd id (length loglist)))
+        (def eval-thd-id
+            (if (> (length loglist-eval) 0)
+                (spawn eval-thd rate
+                    (map
+                        (fn (x) (list (row-divider x rate) (row-threshold x) (ix x -1) 0.0 0))
+                        loglist-eval
+                ))
+                nil
+        ))
+        ; The voltage monitor only fires when the voltage goes below vin-min,
+        ; so it is armed again in case it already is below.
+        (ext-supervisor-rearm vin-mon-id)
         (send-data "Log Started")
 ))
 
@@ -185,7 +320,9 @@
         (if log-running
             (progn
                 (def log-running false)
+                (ext-logger-stop)
                 (wait log-thd-id)
+                (if eval-thd-id (wait eval-thd-id))
                 (send-data "Log stopped")
         ))
 ))
@@ -214,16 +351,16 @@
 (event-enable 'event-data-rx)
 (event-enable 'event-shutdown)
 
-; Voltage monitor thread that stops logging if the voltage drops too low
+; Voltage monitor that stops logging if the voltage drops too low. The
+; voltage is checked by the supervisor library, so this thread only wakes
+; up when the monitor fires.
+(def vin-mon-id (ext-supervisor-add 'vin vin-min true 0.5))
+
 (spawn 30 (fn ()
-        (progn
-            (if (< (get-vin) vin-min)
-                (progn
-                    (stop-log last-can-id)
-                    (sleep 1)
-            ))
-            (sleep 0.01)
-)))
+        (loopwhile t
+            (if (eq (ext-supervisor-wait vin-mon-id) vin-mon-id)
+                (stop-log last-can-id)
+))))
 
 ; Persistent settings
 ; Format: (label . (offset type))
@@ -0,0 +1,1064 @@
+/*
+	Copyright 2026 Benjamin Vedder	benjamin@vedder.se
+
+	This file is part of the VESC firmware.
+
+	The VESC firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The VESC firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vesc_c_if.h"
+#include "rb.h"
+#include "log_codec.h"
+
+#include <math.h>
+#include <string.h>
+
+HEADER
+
+// Number of sampled frames that can be queued before LispBM picks them up
+#define FRAME_QUEUE_LEN		16
+#define MAX_FIELDS			256
+
+// Upper limit for the pre-trigger history in bytes
+#define MAX_HISTORY_BYTES	8192
+
+// Number of status messages that the firmware stores, and the size of one
+// device in ext-logger-can-snapshot
+#define CAN_STATUS_MSGS		10
+#define CAN_SNAPSHOT_LEN	(3 + 17 * 4)
+
+// Value sources. The order must match source_names below.
+typedef enum {
+	SRC_VIN = 0,
+	SRC_CURRENT,
+	SRC_CURRENT_IN,
+	SRC_DUTY,
+	SRC_RPM,
+	SRC_TEMP_FET,
+	SRC_TEMP_MOT,
+	SRC_BATT,
+	SRC_KMH,
+	SRC_ROLL,
+	SRC_PITCH,
+	SRC_YAW,
+	SRC_FAULT,
+	SRC_DIST,
+	SRC_DIST_ABS,
+	SRC_AH,
+	SRC_WH,
+	SRC_AH_CHG,
+	SRC_WH_CHG,
+	SRC_TIME,
+
+	// Sources below take a CAN id
+	SRC_CAN_CURRENT,
+	SRC_CAN_CURRENT_IN,
+	SRC_CAN_DUTY,
+	SRC_CAN_RPM,
+	SRC_CAN_TEMP_FET,
+	SRC_CAN_TEMP_MOTOR,
+	SRC_CAN_AH,
+	SRC_CAN_AH_CHG,
+	SRC_CAN_WH,
+	SRC_CAN_WH_CHG,
+	SRC_CAN_VIN,
+	SRC_CAN_TACHO,
+	SRC_CAN_PID_POS,
+	SRC_CAN_ADC1,
+	SRC_CAN_ADC2,
+	SRC_CAN_ADC3,
+	SRC_CAN_PPM,
+
+	SRC_NUM
+} LOG_SRC;
+
+#define SRC_FIRST_CAN		SRC_CAN_CURRENT
+
+// Names of the sources as LispBM symbols. A plain array is used instead of
+// pointers to strings as this program cannot relocate pointers in its data.
+static const char source_names[SRC_NUM][16] = {
+	"vin",
+	"current",
+	"current-in",
+	"duty",
+	"rpm",
+	"temp-fet",
+	"temp-mot",
+	"batt",
+	"kmh",
+	"roll",
+	"pitch",
+	"yaw",
+	"fault",
+	"dist",
+	"dist-abs",
+	"ah",
+	"wh",
+	"ah-chg",
+	"wh-chg",
+	"time",
+	"can-current",
+	"can-current-in",
+	"can-duty",
+	"can-rpm",
+	"can-temp-fet",
+	"can-temp-motor",
+	"can-ah",
+	"can-ah-chg",
+	"can-wh",
+	"can-wh-chg",
+	"can-vin",
+	"can-tacho",
+	"can-pid-pos",
+	"can-adc1",
+	"can-adc2",
+	"can-adc3",
+	"can-ppm",
+};
+
+// Number of values of one CAN device, in the same order as the CAN sources
+#define CAN_VAL_NUM			(SRC_NUM - SRC_FIRST_CAN)
+#define CAN_VAL(src)		((src) - SRC_FIRST_CAN)
+
+// All status messages of one CAN device, read at once
+typedef struct {
+	int id;
+	uint16_t age_ms; // Age of status message 1
+	int32_t tacho;
+	float vals[CAN_VAL_NUM];
+} can_dev;
+
+typedef struct {
+	uint8_t source;
+	uint8_t can_id;
+	uint8_t can_slot; // Index in can_devs of the data struct
+
+	// The field is sampled every divider frames and only updated when it has
+	// changed more than threshold. In between the last value is repeated so
+	// that all frames have every field.
+	uint16_t divider;
+	float threshold;
+	float value;
+} log_field;
+
+// Triggered logging. Frames are kept in a pre-trigger history at the full rate
+// and only every base_div:th frame is sent while nothing happens. A trigger
+// sends the whole history and all frames for post_time after it.
+typedef struct {
+	bool enabled;
+	float base_rate;
+	float pre_time;
+	float post_time;
+	bool on_fault;
+	float current; // Absolute motor current, 0 to disable
+	float pitch; // Absolute pitch in radians, 0 to disable
+	float vin; // Input voltage sag, 0 to disable
+} trig_cfg;
+
+typedef struct {
+	lbm_uint syms[SRC_NUM];
+
+	lib_thread thread;
+	float rate;
+	int field_num;
+	log_field *fields;
+
+	// The CAN devices that the fields use are read once per frame
+	can_dev can_devs[CAN_STATUS_MSGS];
+	int can_dev_num;
+	int eval_num;
+	float *eval; // Latest values of the fields that are evaluated in lisp
+	float *sample; // Written by the logger thread
+	float *frame; // Read by the extensions
+	rb_t frames;
+	volatile int waiting_cid;
+	volatile uint32_t dropped; // Frames dropped because LispBM did not keep up
+
+	// Compressed output
+	float *scale;
+	int32_t *prev;
+	log_codec_t codec;
+
+	// Triggered logging
+	trig_cfg trig;
+	rb_t history;
+	float *moved;
+	int base_div;
+	int post_frames;
+	int hist_drain; // Window frames at the head of the history that are not sent yet
+	int hist_skip; // Frames at the head of the history that were handled at the base rate
+	volatile bool trig_now;
+	uint32_t start_time;
+} data;
+
+// Reads all status messages of the device with id, using msg as status message
+// 1 if it is given. Messages that the device does not send read as 0, same as
+// canget-*.
+static void can_read_dev(can_dev *dev, int id, can_status_msg *msg) {
+	float *v = dev->vals;
+
+	memset(v, 0, sizeof(dev->vals));
+	dev->id = id;
+	dev->age_ms = 65535;
+	dev->tacho = 0;
+
+	if (!msg) {
+		msg = VESC_IF->can_get_status_msg_id(id);
+	}
+
+	if (msg) {
+		float age_ms = VESC_IF->ts_to_age_s(msg->rx_time) * 1000.0;
+		dev->age_ms = age_ms > 65535.0 ? 65535 : (uint16_t)age_ms;
+		v[CAN_VAL(SRC_CAN_CURRENT)] = msg->current;
+		v[CAN_VAL(SRC_CAN_DUTY)] = msg->duty;
+		v[CAN_VAL(SRC_CAN_RPM)] = msg->rpm;
+	}
+
+	can_status_msg_2 *msg2 = VESC_IF->can_get_status_msg_2_id(id);
+	if (msg2) {
+		v[CAN_VAL(SRC_CAN_AH)] = msg2->amp_hours;
+		v[CAN_VAL(SRC_CAN_AH_CHG)] = msg2->amp_hours_charged;
+	}
+
+	can_status_msg_3 *msg3 = VESC_IF->can_get_status_msg_3_id(id);
+	if (msg3) {
+		v[CAN_VAL(SRC_CAN_WH)] = msg3->watt_hours;
+		v[CAN_VAL(SRC_CAN_WH_CHG)] = msg3->watt_hours_charged;
+	}
+
+	can_status_msg_4 *msg4 = VESC_IF->can_get_status_msg_4_id(id);
+	if (msg4) {
+		v[CAN_VAL(SRC_CAN_TEMP_FET)] = msg4->temp_fet;
+		v[CAN_VAL(SRC_CAN_TEMP_MOTOR)] = msg4->temp_motor;
+		v[CAN_VAL(SRC_CAN_CURRENT_IN)] = msg4->current_in;
+		v[CAN_VAL(SRC_CAN_PID_POS)] = msg4->pid_pos_now;
+	}
+
+	can_status_msg_5 *msg5 = VESC_IF->can_get_status_msg_5_id(id);
+	if (msg5) {
+		v[CAN_VAL(SRC_CAN_VIN)] = msg5->v_in;
+		dev->tacho = msg5->tacho_value;
+		v[CAN_VAL(SRC_CAN_TACHO)] = (float)msg5->tacho_value;
+	}
+
+	can_status_msg_6 *msg6 = VESC_IF->can_get_status_msg_6_id(id);
+	if (msg6) {
+		v[CAN_VAL(SRC_CAN_ADC1)] = msg6->adc_1;
+		v[CAN_VAL(SRC_CAN_ADC2)] = msg6->adc_2;
+		v[CAN_VAL(SRC_CAN_ADC3)] = msg6->adc_3;
+		v[CAN_VAL(SRC_CAN_PPM)] = msg6->ppm;
+	}
+}
+
+static float sample_field(data *d, log_field *f) {
+	switch (f->source) {
+	case SRC_VIN: return VESC_IF->mc_get_input_voltage_filtered();
+	case SRC_CURRENT: return VESC_IF->mc_get_tot_current_filtered();
+	case SRC_CURRENT_IN: return VESC_IF->mc_get_tot_current_in_filtered();
+	case SRC_DUTY: return VESC_IF->mc_get_duty_cycle_now();
+	case SRC_RPM: return VESC_IF->mc_get_rpm();
+	case SRC_TEMP_FET: return VESC_IF->mc_temp_fet_filtered();
+	case SRC_TEMP_MOT: return VESC_IF->mc_temp_motor_filtered();
+	case SRC_BATT: return VESC_IF->mc_get_battery_level(0) * 100.0;
+	case SRC_KMH: return VESC_IF->mc_get_speed() * 3.6;
+	case SRC_ROLL: return VESC_IF->imu_get_roll();
+	case SRC_PITCH: return VESC_IF->imu_get_pitch();
+	case SRC_YAW: return VESC_IF->imu_get_yaw();
+	case SRC_FAULT: return (float)VESC_IF->mc_get_fault();
+	case SRC_DIST: return VESC_IF->mc_get_distance();
+	case SRC_DIST_ABS: return VESC_IF->mc_get_distance_abs();
+	case SRC_AH: return VESC_IF->mc_get_amp_hours(false);
+	case SRC_WH: return VESC_IF->mc_get_watt_hours(false);
+	case SRC_AH_CHG: return VESC_IF->mc_get_amp_hours_charged(false);
+	case SRC_WH_CHG: return VESC_IF->mc_get_watt_hours_charged(false);
+	case SRC_TIME: return VESC_IF->timer_seconds_elapsed_since(d->start_time);
+	default: break;
+	}
+
+	return d->can_devs[f->can_slot].vals[CAN_VAL(f->source)];
+}
+
+// Parses a field of the form (source) or (source can-id)
+static bool parse_field(data *d, lbm_value spec, log_field *f) {
+	if (!VESC_IF->lbm_is_cons(spec)) {
+		return false;
+	}
+
+	lbm_value name = VESC_IF->lbm_car(spec);
+	if (!VESC_IF->lbm_is_symbol(name)) {
+		return false;
+	}
+
+	lbm_uint sym = VESC_IF->lbm_dec_sym(name);
+	int source = -1;
+	for (int i = 0;i < SRC_NUM;i++) {
+		if (d->syms[i] == sym) {
+			source = i;
+			break;
+		}
+	}
+
+	if (source < 0) {
+		return false;
+	}
+
+	f->source = source;
+	f->can_id = 0;
+	f->can_slot = 0;
+	f->divider = 1;
+	f->threshold = 0.0;
+	f->value = 0.0;
+
+	if (source >= SRC_FIRST_CAN) {
+		lbm_value rest = VESC_IF->lbm_cdr(spec);
+		if (!VESC_IF->lbm_is_cons(rest) || !VESC_IF->lbm_is_number(VESC_IF->lbm_car(rest))) {
+			return false;
+		}
+		f->can_id = VESC_IF->lbm_dec_as_i32(VESC_IF->lbm_car(rest));
+	}
+
+	return true;
+}
+
+static void output_frame(data *d, float *frame) {
+	// Drop the oldest frame if LispBM does not keep up
+	if (rb_is_full(&d->frames)) {
+		rb_pop(&d->frames, 0);
+		d->dropped++;
+	}
+	rb_insert(&d->frames, frame);
+}
+
+static bool check_trigger(data *d) {
+	trig_cfg *t = &d->trig;
+
+	if (d->trig_now) {
+		d->trig_now = false;
+		return true;
+	}
+
+	return (t->on_fault && VESC_IF->mc_get_fault() != FAULT_CODE_NONE) ||
+			(t->current > 0.0 && fabsf(VESC_IF->mc_get_tot_current_filtered()) >= t->current) ||
+			(t->pitch > 0.0 && fabsf(VESC_IF->imu_get_pitch()) >= t->pitch) ||
+			(t->vin > 0.0 && VESC_IF->mc_get_input_voltage_filtered() <= t->vin);
+}
+
+static bool trig_base_due(data *d) {
+	if (d->base_div-- <= 1) {
+		d->base_div = (int)roundf(d->rate / d->trig.base_rate);
+		return true;
+	}
+
+	return false;
+}
+
+// Sends the window frames from the history as fast as LispBM picks them up,
+// which keeps them in order.
+static void trig_drain(data *d) {
+	while (d->hist_drain > 0 && !rb_is_full(&d->frames) && rb_pop(&d->history, d->moved)) {
+		rb_insert(&d->frames, d->moved);
+		d->hist_drain--;
+	}
+}
+
+// Passes the sample through the pre-trigger history. Returns the number of frames
+// that are left in the window after the last trigger.
+static int trig_update(data *d, int post_left) {
+	if (check_trigger(d)) {
+		// Frames that already were handled at the base rate are older than the
+		// rest of the history and are not sent again.
+		while (d->hist_skip > 0 && rb_pop(&d->history, d->moved)) {
+			d->hist_skip--;
+		}
+
+		d->hist_skip = 0;
+		post_left = d->post_frames;
+	}
+
+	trig_drain(d);
+
+	if (post_left > 0) {
+		// The whole history is part of the window. Frames that LispBM has not
+		// picked up yet stay in it, so the new frame is dropped if it is full.
+		d->hist_drain = rb_get_item_count(&d->history);
+		if (rb_is_full(&d->history)) {
+			d->dropped++;
+		} else {
+			rb_insert(&d->history, d->sample);
+			d->hist_drain++;
+		}
+
+		trig_drain(d);
+		return post_left - 1;
+	}
+
+	if (!rb_is_full(&d->history)) {
+		// The history fills up after the start and after a window. Frames at the
+		// base rate are sent right away instead of when they leave the history,
+		// so that the output does not pause for pre_time. A window that LispBM
+		// still drains goes on at the full rate until it has caught up.
+		rb_insert(&d->history, d->sample);
+		if (d->hist_drain > 0) {
+			d->hist_drain++;
+		} else if (trig_base_due(d)) {
+			output_frame(d, d->sample);
+			d->hist_skip = rb_get_item_count(&d->history);
+		}
+
+		trig_drain(d);
+		return 0;
+	}
+
+	if (d->hist_drain > 0) {
+		d->dropped++;
+		return 0;
+	}
+
+	// The oldest frame leaves the history. Only the frames at the base rate are
+	// kept, unless they were handled when they came in.
+	rb_pop(&d->history, d->moved);
+	if (d->hist_skip > 0) {
+		d->hist_skip--;
+	} else if (trig_base_due(d)) {
+		output_frame(d, d->moved);
+	}
+
+	rb_insert(&d->history, d->sample);
+	return 0;
+}
+
+static void logger_thd(void *arg) {
+	data *d = (data*)arg;
+	uint32_t frame_cnt = 0;
+	int post_left = 0;
+
+	while (!VESC_IF->should_terminate()) {
+		uint32_t frame_start = VESC_IF->timer_time_now();
+
+		// One snapshot per frame instead of looking up the messages for every
+		// CAN field
+		for (int i = 0;i < d->can_dev_num;i++) {
+			can_read_dev(&d->can_devs[i], d->can_devs[i].id, 0);
+		}
+
+		for (int i = 0;i < d->field_num;i++) {
+			log_field *f = &d->fields[i];
+
+			// Slow fields are spread out over the frames to even out the load
+			if (frame_cnt == 0 || ((frame_cnt + i) % f->divider) == 0) {
+				float val = sample_field(d, f);
+				if (frame_cnt == 0 || fabsf(val - f->value) >= f->threshold) {
+					f->value = val;
+				}
+			}
+
+			d->sample[i] = f->value;
+		}
+		frame_cnt++;
+
+		// The fields from lisp are stored with the frame, so that frames from the
+		// history carry the values from their own time.
+		for (int i = 0;i < d->eval_num;i++) {
+			d->sample[d->field_num + i] = d->eval[i];
+		}
+
+		if (d->history.data) {
+			post_left = trig_update(d, post_left);
+		} else {
+			output_frame(d, d->sample);
+		}
+
+		// Only wake up LispBM when there is a frame, as most samples just go to the
+		// history in triggered mode. The context is blocked after ext-logger-wait
+		// has returned, so unblocking it fails if this runs in between. The cid is
+		// kept and the next sample tries again in that case.
+		int cid = d->waiting_cid;
+		if (cid >= 0 && !rb_is_empty(&d->frames) &&
+				VESC_IF->lbm_unblock_ctx(cid, VESC_IF->lbm_enc_sym_true)) {
+			d->waiting_cid = -1;
+		}
+
+		// Keep the rate regardless of how long sampling took
+		float left = 1.0 / d->rate - VESC_IF->timer_seconds_elapsed_since(frame_start);
+		if (left > 0.0) {
+			VESC_IF->sleep_us((uint32_t)(left * 1.0e6));
+		}
+	}
+}
+
+static void logger_free(data *d) {
+	if (d->fields) {
+		VESC_IF->free(d->fields);
+	}
+	if (d->eval) {
+		VESC_IF->free(d->eval);
+	}
+	if (d->sample) {
+		VESC_IF->free(d->sample);
+	}
+	if (d->frame) {
+		VESC_IF->free(d->frame);
+	}
+	if (d->frames.data) {
+		rb_free(&d->frames);
+	}
+	if (d->scale) {
+		VESC_IF->free(d->scale);
+	}
+	if (d->prev) {
+		VESC_IF->free(d->prev);
+	}
+	if (d->history.data) {
+		rb_free(&d->history);
+	}
+	if (d->moved) {
+		VESC_IF->free(d->moved);
+	}
+
+	d->scale = 0;
+	d->prev = 0;
+	d->history.data = 0;
+	d->moved = 0;
+	d->fields = 0;
+	d->eval = 0;
+	d->sample = 0;
+	d->frame = 0;
+	d->frames.data = 0;
+	d->field_num = 0;
+	d->eval_num = 0;
+	d->can_dev_num = 0;
+}
+
+static void logger_stop(data *d) {
+	if (d->thread) {
+		VESC_IF->request_terminate(d->thread);
+		d->thread = 0;
+
+		logger_free(d);
+	}
+
+	int cid = d->waiting_cid;
+	if (cid >= 0) {
+		d->waiting_cid = -1;
+		VESC_IF->lbm_unblock_ctx(cid, VESC_IF->lbm_enc_sym_nil);
+	}
+}
+
+// (ext-logger-field-ok spec)
+static lbm_value ext_field_ok(lbm_value *args, lbm_uint argn) {
+	if (argn != 1) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	log_field f;
+	return parse_field(d, args[0], &f) ? VESC_IF->lbm_enc_sym_true : VESC_IF->lbm_enc_sym_nil;
+}
+
+// Returns the next element of the list in *lst as a number, or def if the list
+// is empty.
+static float next_num(lbm_value *lst, float def) {
+	if (!VESC_IF->lbm_is_cons(*lst)) {
+		return def;
+	}
+
+	lbm_value v = VESC_IF->lbm_car(*lst);
+	*lst = VESC_IF->lbm_cdr(*lst);
+	return VESC_IF->lbm_is_number(v) ? VESC_IF->lbm_dec_as_float(v) : def;
+}
+
+// (ext-logger-start rate fields optPrecisions optDividers optThresholds optEvalNum)
+//
+// precisions: Number of decimals that are kept for each field in the compressed
+// output, including the fields from ext-logger-set-eval
+// dividers: Sample the field at rate / divider
+// thresholds: Only update the field when it changes more than this
+// evalNum: Number of fields from ext-logger-set-eval after the native fields
+static lbm_value ext_start(lbm_value *args, lbm_uint argn) {
+	if (argn < 2 || argn > 6 || !VESC_IF->lbm_is_number(args[0]) ||
+			(argn == 6 && !VESC_IF->lbm_is_number(args[5]))) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	logger_stop(d);
+
+	float rate = VESC_IF->lbm_dec_as_float(args[0]);
+	if (rate <= 0.0 || rate > 1000.0) {
+		VESC_IF->lbm_set_error_reason("Invalid Rate");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	int num = 0;
+	lbm_value curr = args[1];
+	while (VESC_IF->lbm_is_cons(curr)) {
+		num++;
+		curr = VESC_IF->lbm_cdr(curr);
+	}
+
+	int eval_num = argn == 6 ? VESC_IF->lbm_dec_as_i32(args[5]) : 0;
+
+	if (eval_num < 0 || num + eval_num > MAX_FIELDS) {
+		VESC_IF->lbm_set_error_reason("Too Many Fields");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	// Without fields the thread still runs and only provides the timing
+	int alloc_num = num + eval_num > 0 ? num + eval_num : 1;
+
+	float pre_frames = d->trig.enabled ? ceilf(d->trig.pre_time * rate) : 0.0;
+	if (pre_frames * (float)(alloc_num * sizeof(float)) > (float)MAX_HISTORY_BYTES) {
+		VESC_IF->lbm_set_error_reason("Too Long Pre-Trigger Time");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	d->fields = VESC_IF->malloc((num > 0 ? num : 1) * sizeof(log_field));
+	d->eval = VESC_IF->malloc((eval_num > 0 ? eval_num : 1) * sizeof(float));
+	d->sample = VESC_IF->malloc(alloc_num * sizeof(float));
+	d->frame = VESC_IF->malloc(alloc_num * sizeof(float));
+	rb_init_alloc(&d->frames, alloc_num * sizeof(float), FRAME_QUEUE_LEN);
+	d->scale = VESC_IF->malloc(alloc_num * sizeof(float));
+	d->prev = VESC_IF->malloc(alloc_num * sizeof(int32_t));
+
+	bool trig_ok = true;
+	if (d->trig.enabled) {
+		rb_init_alloc(&d->history, alloc_num * sizeof(float), pre_frames > 0.0 ? (int)pre_frames : 1);
+		d->moved = VESC_IF->malloc(alloc_num * sizeof(float));
+		trig_ok = d->history.data && d->moved;
+	}
+
+	if (!d->fields || !d->eval || !d->sample || !d->frame || !d->frames.data ||
+			!d->scale || !d->prev || !trig_ok) {
+		logger_free(d);
+		VESC_IF->lbm_set_error_reason("Not enough memory");
+		return VESC_IF->lbm_enc_sym_merror;
+	}
+
+	curr = args[1];
+	d->can_dev_num = 0;
+	for (int i = 0;i < num;i++) {
+		log_field *f = &d->fields[i];
+		if (!parse_field(d, VESC_IF->lbm_car(curr), f)) {
+			logger_free(d);
+
+			VESC_IF->lbm_set_error_reason("Unknown Field");
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+		curr = VESC_IF->lbm_cdr(curr);
+
+		if (f->source < SRC_FIRST_CAN) {
+			continue;
+		}
+
+		int slot = 0;
+		while (slot < d->can_dev_num && d->can_devs[slot].id != f->can_id) {
+			slot++;
+		}
+
+		if (slot == d->can_dev_num) {
+			if (slot == CAN_STATUS_MSGS) {
+				logger_free(d);
+
+				VESC_IF->lbm_set_error_reason("Too Many CAN Devices");
+				return VESC_IF->lbm_enc_sym_eerror;
+			}
+
+			can_read_dev(&d->can_devs[slot], f->can_id, 0);
+			d->can_dev_num++;
+		}
+
+		f->can_slot = slot;
+	}
+
+	// Two decimals by default, same as log-config-field
+	lbm_value prec = argn >= 3 ? args[2] : VESC_IF->lbm_enc_sym_nil;
+	for (int i = 0;i < num + eval_num;i++) {
+		d->scale[i] = powf(10.0, roundf(next_num(&prec, 2.0)));
+	}
+
+	// One key frame per second, so that a decoder can pick up a running log
+	log_codec_init(&d->codec, num + eval_num, d->scale, d->prev, (int)ceilf(rate));
+
+	lbm_value div = argn >= 4 ? args[3] : VESC_IF->lbm_enc_sym_nil;
+	lbm_value th = argn >= 5 ? args[4] : VESC_IF->lbm_enc_sym_nil;
+	for (int i = 0;i < num;i++) {
+		log_field *f = &d->fields[i];
+
+		float divider = roundf(next_num(&div, 1.0));
+		f->divider = divider < 1.0 ? 1 : (divider > 65535.0 ? 65535 : (uint16_t)divider);
+		f->threshold = fabsf(next_num(&th, 0.0));
+	}
+
+	d->base_div = 0;
+	d->post_frames = (int)ceilf(d->trig.post_time * rate);
+	d->hist_drain = 0;
+	d->hist_skip = 0;
+	d->dropped = 0;
+	d->trig_now = false;
+	d->start_time = VESC_IF->timer_time_now();
+
+	for (int i = 0;i < eval_num;i++) {
+		d->eval[i] = 0.0;
+	}
+
+	d->field_num = num;
+	d->eval_num = eval_num;
+	d->rate = rate;
+	d->thread = VESC_IF->spawn(logger_thd, 1024, "Logger", d);
+	if (!d->thread) {
+		logger_free(d);
+		VESC_IF->lbm_set_error_reason("Could not start thread");
+		return VESC_IF->lbm_enc_sym_merror;
+	}
+
+	return VESC_IF->lbm_enc_i(num);
+}
+
+// (ext-logger-set-eval values), sets the fields that are evaluated in lisp. They
+// are stored with every frame that is sampled until the next call.
+static lbm_value ext_set_eval(lbm_value *args, lbm_uint argn) {
+	if (argn != 1) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	if (!d->thread) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	lbm_value curr = args[0];
+	for (int i = 0;i < d->eval_num;i++) {
+		d->eval[i] = next_num(&curr, d->eval[i]);
+	}
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-logger-set-trigger base-rate pre-time post-time triggers), enables triggered
+// logging from the next ext-logger-start. The triggers are an assoc list with any
+// of (fault . 1) (current . amps) (pitch . radians) (vin . volts). Without
+// arguments triggered logging is disabled.
+static lbm_value ext_set_trigger(lbm_value *args, lbm_uint argn) {
+	data *d = (data*)ARG;
+
+	if (argn == 0) {
+		d->trig.enabled = false;
+		return VESC_IF->lbm_enc_sym_true;
+	}
+
+	if (argn != 4 || !VESC_IF->lbm_is_number(args[0]) ||
+			!VESC_IF->lbm_is_number(args[1]) || !VESC_IF->lbm_is_number(args[2])) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	trig_cfg t;
+	memset(&t, 0, sizeof(t));
+	t.base_rate = VESC_IF->lbm_dec_as_float(args[0]);
+	t.pre_time = VESC_IF->lbm_dec_as_float(args[1]);
+	t.post_time = VESC_IF->lbm_dec_as_float(args[2]);
+
+	if (t.base_rate <= 0.0 || t.pre_time < 0.0 || t.post_time < 0.0) {
+		VESC_IF->lbm_set_error_reason("Invalid Trigger Timing");
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	lbm_value curr = args[3];
+	while (VESC_IF->lbm_is_cons(curr)) {
+		lbm_value pair = VESC_IF->lbm_car(curr);
+		curr = VESC_IF->lbm_cdr(curr);
+
+		if (!VESC_IF->lbm_is_cons(pair) || !VESC_IF->lbm_is_symbol(VESC_IF->lbm_car(pair)) ||
+				!VESC_IF->lbm_is_number(VESC_IF->lbm_cdr(pair))) {
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+
+		lbm_uint sym = VESC_IF->lbm_dec_sym(VESC_IF->lbm_car(pair));
+		float val = VESC_IF->lbm_dec_as_float(VESC_IF->lbm_cdr(pair));
+
+		if (sym == d->syms[SRC_FAULT]) {
+			t.on_fault = val != 0.0;
+		} else if (sym == d->syms[SRC_CURRENT]) {
+			t.current = fabsf(val);
+		} else if (sym == d->syms[SRC_PITCH]) {
+			t.pitch = fabsf(val);
+		} else if (sym == d->syms[SRC_VIN]) {
+			t.vin = val;
+		} else {
+			VESC_IF->lbm_set_error_reason("Unknown Trigger");
+			return VESC_IF->lbm_enc_sym_eerror;
+		}
+	}
+
+	t.enabled = true;
+	d->trig = t;
+
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-logger-trigger), triggers a window from lisp
+static lbm_value ext_trigger(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+
+	data *d = (data*)ARG;
+	if (!d->thread || !d->history.data) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	d->trig_now = true;
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-logger-dropped), number of frames that were dropped since the start
+// because LispBM did not pick them up in time.
+static lbm_value ext_dropped(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+	return VESC_IF->lbm_enc_u32(((data*)ARG)->dropped);
+}
+
+// (ext-logger-stop)
+static lbm_value ext_stop(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+	logger_stop((data*)ARG);
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-logger-wait), blocks until a frame is available. Returns nil if the logger
+// is not running.
+static lbm_value ext_wait(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+
+	data *d = (data*)ARG;
+	if (!d->thread) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	if (!rb_is_empty(&d->frames)) {
+		return VESC_IF->lbm_enc_sym_true;
+	}
+
+	d->waiting_cid = VESC_IF->lbm_get_current_cid();
+	VESC_IF->lbm_block_ctx_from_extension();
+	return VESC_IF->lbm_enc_sym_true;
+}
+
+// (ext-logger-get), returns the oldest sampled frame as a list of values or nil
+// if there are no new frames. The native fields come first, followed by the ones
+// from ext-logger-set-eval. Without fields a frame is returned as t, so that the
+// frames can still be counted.
+static lbm_value ext_get(lbm_value *args, lbm_uint argn) {
+	(void)args; (void)argn;
+
+	data *d = (data*)ARG;
+	if (!d->thread || !rb_pop(&d->frames, d->frame)) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	int num = d->field_num + d->eval_num;
+	if (num == 0) {
+		return VESC_IF->lbm_enc_sym_true;
+	}
+
+	lbm_value res = VESC_IF->lbm_enc_sym_nil;
+	for (int i = num - 1;i >= 0;i--) {
+		lbm_value val = VESC_IF->lbm_enc_float(d->frame[i]);
+		if (val == VESC_IF->lbm_enc_sym_merror) {
+			return val;
+		}
+
+		res = VESC_IF->lbm_cons(val, res);
+		if (res == VESC_IF->lbm_enc_sym_merror) {
+			return res;
+		}
+	}
+
+	return res;
+}
+
+// (ext-logger-get-bin optMaxLen), returns the queued frames compressed into a
+// byte array of at most optMaxLen bytes, or nil if there are no new frames.
+static lbm_value ext_get_bin(lbm_value *args, lbm_uint argn) {
+	if (argn > 1 || (argn == 1 && !VESC_IF->lbm_is_number(args[0]))) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	data *d = (data*)ARG;
+	if (!d->thread || rb_is_empty(&d->frames)) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	int32_t frame_len = LOG_CODEC_MAX_LEN(d->codec.field_num);
+	int32_t max_len = argn == 1 ? VESC_IF->lbm_dec_as_i32(args[0]) : 256;
+	if (max_len < frame_len) {
+		max_len = frame_len;
+	}
+
+	uint8_t *buffer = VESC_IF->malloc(max_len);
+	if (!buffer) {
+		return VESC_IF->lbm_enc_sym_merror;
+	}
+
+	int32_t ind = 0;
+	while ((ind + frame_len) <= max_len && rb_pop(&d->frames, d->frame)) {
+		log_codec_append_frame(&d->codec, d->frame, buffer, &ind);
+	}
+
+	lbm_value res;
+	if (VESC_IF->lbm_create_byte_array(&res, ind)) {
+		lbm_array_header_t *array = (lbm_array_header_t*)VESC_IF->lbm_car(res);
+		memcpy(array->data, buffer, ind);
+	} else {
+		// The frames are lost, so start over with a key frame
+		log_codec_reset(&d->codec);
+		res = VESC_IF->lbm_enc_sym_merror;
+	}
+
+	VESC_IF->free(buffer);
+
+	return res;
+}
+
+static void append_u32(uint8_t *buffer, uint32_t number, int32_t *index) {
+	buffer[(*index)++] = number >> 24;
+	buffer[(*index)++] = number >> 16;
+	buffer[(*index)++] = number >> 8;
+	buffer[(*index)++] = number;
+}
+
+static void append_f32(uint8_t *buffer, float number, int32_t *index) {
+	uint32_t res;
+	memcpy(&res, &number, sizeof(res));
+	append_u32(buffer, res, index);
+}
+
+// Appends the status of one CAN device in the layout that is described in the
+// README
+static void append_can_dev(uint8_t *buffer, const can_dev *dev, int32_t *index) {
+	const float *v = dev->vals;
+
+	buffer[(*index)++] = dev->id;
+	buffer[(*index)++] = dev->age_ms >> 8;
+	buffer[(*index)++] = dev->age_ms;
+
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_CURRENT)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_DUTY)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_RPM)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_AH)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_AH_CHG)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_WH)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_WH_CHG)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_TEMP_FET)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_TEMP_MOTOR)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_CURRENT_IN)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_PID_POS)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_VIN)], index);
+	append_u32(buffer, (uint32_t)dev->tacho, index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_ADC1)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_ADC2)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_ADC3)], index);
+	append_f32(buffer, v[CAN_VAL(SRC_CAN_PPM)], index);
+}
+
+// (ext-logger-can-snapshot optMaxAge), returns the status of all CAN devices that
+// have sent status message 1 within optMaxAge seconds as one byte array, or nil
+// if there are none. See the README for the layout.
+static lbm_value ext_can_snapshot(lbm_value *args, lbm_uint argn) {
+	if (argn > 1 || (argn == 1 && !VESC_IF->lbm_is_number(args[0]))) {
+		return VESC_IF->lbm_enc_sym_eerror;
+	}
+
+	float max_age = argn == 1 ? VESC_IF->lbm_dec_as_float(args[0]) : 1.0;
+
+	// Pick the devices first, so that the array can be allocated at once
+	can_status_msg *devs[CAN_STATUS_MSGS];
+	int dev_num = 0;
+	for (int i = 0;i < CAN_STATUS_MSGS;i++) {
+		can_status_msg *msg = VESC_IF->can_get_status_msg_index(i);
+		if (msg && msg->id >= 0 && VESC_IF->ts_to_age_s(msg->rx_time) < max_age) {
+			devs[dev_num++] = msg;
+		}
+	}
+
+	if (dev_num == 0) {
+		return VESC_IF->lbm_enc_sym_nil;
+	}
+
+	lbm_value res;
+	if (!VESC_IF->lbm_create_byte_array(&res, dev_num * CAN_SNAPSHOT_LEN)) {
+		return VESC_IF->lbm_enc_sym_merror;
+	}
+
+	lbm_array_header_t *array = (lbm_array_header_t*)VESC_IF->lbm_car(res);
+	uint8_t *buffer = (uint8_t*)array->data;
+	int32_t ind = 0;
+	for (int i = 0;i < dev_num;i++) {
+		can_dev dev;
+		can_read_dev(&dev, devs[i]->id, devs[i]);
+		append_can_dev(buffer, &dev, &ind);
+	}
+
+	return res;
+}
+
+static void stop(void *arg) {
+	data *d = (data*)arg;
+	logger_stop(d);
+	VESC_IF->free(d);
+}
+
+INIT_FUN(lib_info *info) {
+	INIT_START
+
+	data *d = VESC_IF->malloc(sizeof(data));
+	if (!d) {
+		return false;
+	}
+
+	for (int i = 0;i < SRC_NUM;i++) {
+		VESC_IF->lbm_add_symbol_const((char*)source_names[i], &d->syms[i]);
+	}
+
+	d->thread = 0;
+	d->rate = 10.0;
+	d->field_num = 0;
+	d->fields = 0;
+	d->can_dev_num = 0;
+	d->eval_num = 0;
+	d->eval = 0;
+	d->sample = 0;
+	d->frame = 0;
+	d->frames.data = 0;
+	d->waiting_cid = -1;
+	d->scale = 0;
+	d->prev = 0;
+	d->history.data = 0;
+	d->moved = 0;
+	memset(&d->trig, 0, sizeof(d->trig));
+
+	VESC_IF->lbm_add_extension("ext-logger-field-ok", ext_field_ok);
+	VESC_IF->lbm_add_extension("ext-logger-start", ext_start);
+	VESC_IF->lbm_add_extension("ext-logger-stop", ext_stop);
+	VESC_IF->lbm_add_extension("ext-logger-set-eval", ext_set_eval);
+	VESC_IF->lbm_add_extension("ext-logger-set-trigger", ext_set_trigger);
+	VESC_IF->lbm_add_extension("ext-logger-trigger", ext_trigger);
+	VESC_IF->lbm_add_extension("ext-logger-dropped", ext_dropped);
+	VESC_IF->lbm_add_extension("ext-logger-wait", ext_wait);
+	VESC_IF->lbm_add_extension("ext-logger-get", ext_get);
+	VESC_IF->lbm_add_extension("ext-logger-get-bin", ext_get_bin);
+	VESC_IF->lbm_add_extension("ext-logger-can-snapshot", ext_can_snapshot);
+
+	info->stop_fun = stop;
+	info->arg = d;
+
+	return true;
+}